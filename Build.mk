@@ -87,8 +87,6 @@ $(addsuffix _codestyle, $1):
 endef
 
 define header-define
-${OUTDIR}:
-	$(Q)$(MKDIR) $$@
 $(addsuffix _header, $1): ${OUTDIR}
 	$(Q) echo HEADER $1; $(CP) $1 ${OUTDIR}/
 endef
@@ -114,9 +112,12 @@ ${OUTDIR}/.$1/%.o: %.cpp
 	$(Q) echo CPP $$<; $(MKDIR) $$(dir $$@); $(compile_cpp)
 endef
 
+# Targets in one Makefile may share sources; each source gets its codestyle
+# rule only once.
 define base-define
 $(eval $(foreach H,$($1-header-y), $(eval $(call header-define,$H))))
-$(eval $(foreach S,$($1-source-y), $(eval $(call code-style-define,$S))))
+$(eval $(foreach S,$(filter-out $(codestyle-sources),$($1-source-y)), $(eval $(call code-style-define,$S))))
+$(eval codestyle-sources += $($1-source-y))
 $(eval $(foreach D,$($1-depends-y),$(eval $(call depends-define,$D))))
 
 $(eval $1-incs		= $(addprefix -I, $($1-include-y)) $(patsubst %,-I ${WSDIR}/%/install/usr/include,$($1-depends-y)))
@@ -165,6 +166,9 @@ $(addsuffix _uninstall, $(subst /,-, $(subst :,-, $1))):
 	$(Q) echo REMOVE $(word 1, $(subst :, ,$1)); $(RM) ${DESTDIR}${PREFIX}/$(word 2, $(subst :, ,$1))/$(word 1, $(subst :, ,$1))
 endef
 
+${OUTDIR}:
+	$(Q)$(MKDIR) $@
+
 $(eval $(foreach P,$(proj-y),$(eval $(call proj-define,$P))))
 $(eval $(foreach D,$(dir-y),$(eval $(call dir-define,$D))))
 $(eval $(foreach T,$(target-y), $(eval $(call target-define,$T))))
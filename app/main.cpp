@@ -1,4 +1,5 @@
-#include "evloop.h"
+#include "evloop_group.h"
+#include "connection.h"
 #include <iostream>
 #include <unistd.h>
 #include <sys/socket.h>
@@ -6,30 +7,25 @@
 #include <signal.h>
 #include <string.h>
 
-EvLoop* g_ev_ = nullptr;
-
-void signalHandler(int sig) {
-    if (g_ev_ && sig == SIGINT) {
-        std::cout << "\nReceived SIGINT, stopping event loop..." << std::endl;
-        g_ev_->stop();
-    }
-}
-
+// One instance per loop; only touched from that loop's thread.
 class TcpServer {
 private:
-    int server_fd_;
-    EvLoop* ev_;
+    LocalEvLoopGroup* group_;
+    size_t index_;
+    LocalEvLoop* ev_;
     int stats_timer_id_;
     int connection_count_;
+    uint64_t accepted_;
     struct ClientInfo {
         int fd;
         int timer_id;
         uint64_t rbytes;
+        std::shared_ptr<LocalConnection> conn;
         ClientInfo(int fd) : fd(fd), timer_id(-1), rbytes(0) { }
     };
     std::unordered_map<int, std::unique_ptr<ClientInfo>> client_map_;
 
-    bool add_client(int fd) {
+    bool add_client(int fd, std::shared_ptr<LocalConnection> conn) {
         if (fd < 0) {
             return false;
         }
@@ -40,7 +36,8 @@ private:
         }
 
         client_map_[fd] = std::make_unique<ClientInfo>(fd);
-        int timer_id = ev_->add_timer(3000,
+        client_map_[fd]->conn = std::move(conn);
+        int timer_id = ev_->add_timer(std::chrono::seconds(3), std::chrono::milliseconds(500),
                         [this, fd](int timer_id) {
                             auto it = client_map_.find(fd);
                             if (it == client_map_.end()) {
@@ -50,7 +47,7 @@ private:
                             std::cout << "=== Client Stats (Timer ID: " << timer_id << ") Client "<< fd << "===" << std::endl;
                             std::cout << "Receive Bytes: " << it->second->rbytes << std::endl;
                             std::cout << "=========================================" << std::endl;
-                        }, true);
+                        }, true, TimerMode::WHEEL);
         client_map_[fd]->timer_id = timer_id;
         return true;
     }
@@ -66,52 +63,29 @@ private:
     }
 
 public:
-    TcpServer(EvLoop* em) : server_fd_(-1), ev_(em),
-        stats_timer_id_(-1), connection_count_(0) {}
+    TcpServer(LocalEvLoopGroup* group, size_t index) : group_(group), index_(index),
+        ev_(&group->loop(index)), stats_timer_id_(-1), connection_count_(0), accepted_(0) {}
     ~TcpServer() {
         stop();
     }
 
-    bool start(int port) {
-        server_fd_ = socket(AF_INET, SOCK_STREAM, 0);
-        if (server_fd_ < 0) {
-            perror("socket");
-            return false;
-        }
-
-        int opt = 1;
-        setsockopt(server_fd_, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
-
-        sockaddr_in addr{};
-        addr.sin_family = AF_INET;
-        addr.sin_addr.s_addr = INADDR_ANY;
-        addr.sin_port = htons(port);
-
-        if (bind(server_fd_, (sockaddr*)&addr, sizeof(addr)) < 0) {
-            perror("bind");
-            return false;
-        }
-
-        if (listen(server_fd_, 10) < 0) {
-            perror("listen");
-            return false;
-        }
-
-        bool success = ev_->add(server_fd_, POLLIN,
-                                   [this](int fd, short events, short revents) {
-                                   this->handle_server_event(fd, events, revents);
-                                   });
-
-        if (!success) {
-            return false;
-        }
-
-        stats_timer_id_ = ev_->add_timer(10000,
+    bool start() {
+        ev_->enable_stats();
+        size_t index = index_;
+        ev_->enable_watchdog(std::chrono::milliseconds(200), [index](const StallReport& report) {
+            std::cerr << "Loop " << index << " stalled for "
+                << report.stalled.count() / 1000000 << "ms (fd " << report.fd
+                << ", timer " << report.timer_id << ")" << std::endl;
+            for (const auto& frame : report.backtrace) {
+                std::cerr << "    " << frame << std::endl;
+            }
+        }, SIGUSR2);
+        stats_timer_id_ = ev_->add_timer(std::chrono::seconds(10), std::chrono::seconds(1),
                                          [this](int timer_id) {
                                          this->print_stats(timer_id);
                                          }, true);
 
-        return true;
+        return stats_timer_id_ >= 0;
     }
 
     void stop() {
@@ -119,96 +93,94 @@ public:
             ev_->remove_timer(stats_timer_id_);
             stats_timer_id_ = -1;
         }
-
-        if (server_fd_ >= 0) {
-            ev_->remove(server_fd_);
-            close(server_fd_);
-            server_fd_ = -1;
-        }
     }
 
-private:
-    void handle_server_event(int fd, short events, short revents) {
-        (void)events;
-        if (revents & POLLIN) {
-            sockaddr_in client_addr{};
-            socklen_t client_len = sizeof(client_addr);
-
-            int client_fd = accept(fd, (sockaddr*)&client_addr, &client_len);
-            if (client_fd >= 0) {
-                connection_count_++;
-                std::cout << "New client connected: " << client_fd
-                    << " (total: " << connection_count_ << ")" << std::endl;
-
-                ev_->add(client_fd, POLLIN,
-                            [this](int cfd, short ev, short rev) {
-                            this->handle_client_event(cfd, ev, rev);
-                            });
-                ev_->add_timer(30000,
-                               [this, client_fd](int timer_id) {
-                               (void) timer_id;
-                               std::cout << "Auto-disconnecting client " << client_fd << std::endl;
-                               this->disconnect_client(client_fd);
-                               }, false);
-                add_client(client_fd);
+    void add_connection(int client_fd) {
+        connection_count_++;
+        accepted_++;
+        std::cout << "New client connected: " << client_fd << " on loop " << index_
+            << " (total: " << connection_count_ << ")" << std::endl;
+
+        auto conn = std::make_shared<LocalConnection>(*ev_, client_fd);
+        conn->set_data_callback([this](LocalConnection& conn, ChainBuffer& input) {
+            this->handle_client_data(conn, input);
+        });
+        conn->set_close_callback([this, client_fd](LocalConnection& conn, int error) {
+            (void)conn;
+            if (error) {
+                std::cout << "Client " << client_fd << " error: " << strerror(error) << std::endl;
             }
+            this->client_closed(client_fd);
+        });
+        // Stop reading from a client that does not read its echoes.
+        conn->set_watermarks(64 * 1024, 1024 * 1024,
+                             [](LocalConnection& conn, size_t pending) {
+                             (void)pending;
+                             conn.pause_reading();
+                             },
+                             [](LocalConnection& conn, size_t pending) {
+                             (void)pending;
+                             conn.resume_reading();
+                             });
+        add_client(client_fd, conn);
+        if (!conn->start()) {
+            conn->close();
+            return;
         }
-
-        if (revents & (POLLERR | POLLHUP)) {
-            std::cerr << "Server socket error!" << std::endl;
-        }
+        ev_->add_timer(30000,
+                       [this, client_fd](int timer_id) {
+                       (void) timer_id;
+                       std::cout << "Auto-disconnecting client " << client_fd << std::endl;
+                       this->disconnect_client(client_fd);
+                       }, false, TimerMode::WHEEL);
     }
 
-    void handle_client_event(int client_fd, short events, short revents) {
-        (void)events;
-        if (revents & POLLIN) {
-            char buffer[1024];
-            ssize_t bytes = read(client_fd, buffer, sizeof(buffer) - 1);
-
-            if (bytes > 0) {
-                buffer[bytes] = '\0';
-                std::cout << "Received from client " << client_fd << ": " << buffer;
-                int rc = write(client_fd, buffer, bytes);
-                if (rc != bytes) {
-                    disconnect_client(client_fd);
-                }
-                client_map_[client_fd]->rbytes += bytes;
-            } else if (bytes == 0) {
-                disconnect_client(client_fd);
-            }
-        }
+private:
+    void handle_client_data(LocalConnection& conn, ChainBuffer& input) {
+        std::string data = input.take_all();
+        std::cout << "Received from client " << conn.fd() << ": " << data;
+        client_map_[conn.fd()]->rbytes += data.size();
+        conn.send(data);
+    }
 
-        if (revents & (POLLERR | POLLHUP)) {
-            std::cout << "Client " << client_fd << " error, closing" << std::endl;
-            disconnect_client(client_fd);
+    void disconnect_client(int client_fd) {
+        auto it = client_map_.find(client_fd);
+        if (it == client_map_.end()) {
+            return;
         }
+        it->second->conn->close();
     }
 
-    void disconnect_client(int client_fd) {
+    void client_closed(int client_fd) {
+        if (!remove_client(client_fd)) {
+            return;
+        }
         connection_count_--;
+        group_->release(index_);
         std::cout << "Client " << client_fd << " disconnected (remaining: "
             << connection_count_ << ")" << std::endl;
-        remove_client(client_fd);
-        ev_->remove(client_fd);
-        close(client_fd);
     }
 
     void print_stats(int timer_id) {
-        std::cout << "=== Server Stats (Timer ID: " << timer_id << ") ===" << std::endl;
+        std::cout << "=== Server Stats loop " << index_ << " (Timer ID: " << timer_id << ") ===" << std::endl;
         std::cout << "Active connections: " << connection_count_ << std::endl;
+        std::cout << "Accepted: " << accepted_ << " (" << accepted_ / 10.0 << "/s)" << std::endl;
         std::cout << "Total FDs monitored: " << ev_->get_fd_count() << std::endl;
+        std::cout << "Timer wakeups saved: " << ev_->get_wakeups_saved() << std::endl;
+        std::cout << "Loop stats: " << ev_->get_stats().to_json() << std::endl;
         std::cout << "=========================================" << std::endl;
+        accepted_ = 0;
     }
 };
 
 class HeartbeatService {
 private:
-    EvLoop* ev_;
+    LocalEvLoop* ev_;
     int heartbeat_timer_id_;
     int counter_;
 
 public:
-    HeartbeatService(EvLoop* em) : ev_(em),
+    HeartbeatService(LocalEvLoop* em) : ev_(em),
         heartbeat_timer_id_(-1), counter_(0) {}
 
     ~HeartbeatService() {
@@ -216,7 +188,8 @@ public:
     }
 
     bool start(int interval_ms) {
-        heartbeat_timer_id_ = ev_->add_timer(interval_ms,
+        heartbeat_timer_id_ = ev_->add_timer(std::chrono::milliseconds(interval_ms),
+                                             std::chrono::milliseconds(interval_ms / 10),
                                              [this](int timer_id) {
                                              this->send_heartbeat(timer_id);
                                              }, true);
@@ -249,34 +222,73 @@ private:
     }
 };
 
-int main() {
+// Usage: evloop [threads] [reuseport|round-robin|least-loaded]
+int main(int argc, char** argv) {
+    size_t threads = argc > 1 ? strtoul(argv[1], nullptr, 10) : std::thread::hardware_concurrency();
+    std::string mode = argc > 2 ? argv[2] : "reuseport";
 
-    EvLoop ev;
-    g_ev_ = &ev;
+    LocalEvLoopGroup group(threads, BackendType::EPOLL, true);
 
-    signal(SIGINT, signalHandler);
+    std::vector<std::unique_ptr<TcpServer>> servers;
+    for (size_t i = 0; i < group.size(); i++) {
+        servers.push_back(std::make_unique<TcpServer>(&group, i));
+        servers.back()->start();
+    }
 
-    TcpServer server(&ev);
+    auto on_accept = [&servers](size_t index, int fd) {
+        servers[index]->add_connection(fd);
+    };
 
-    if (!server.start(9000)) {
+    // Bound the accepts per wakeup so a connection storm cannot starve the
+    // clients already being served on the accepting loop.
+    group.set_accept_budget(32);
+
+    bool success;
+    if (mode == "reuseport") {
+        success = group.listen_reuseport(9000, on_accept);
+    } else {
+        HandoffPolicy policy = mode == "least-loaded" ? HandoffPolicy::LEAST_LOADED
+                                                      : HandoffPolicy::ROUND_ROBIN;
+        success = group.listen_single(9000, on_accept, policy);
+    }
+    if (!success) {
         std::cerr << "Failed to start server" << std::endl;
         return 1;
     }
-    std::cout << "Server started on port 9000" << std::endl;
-    HeartbeatService heartbeat(&ev);
+    std::cout << "Server started on port 9000 with " << group.size()
+        << " loops (" << mode << ")" << std::endl;
+
+    HeartbeatService heartbeat(&group.loop(0));
     heartbeat.start(2000);
 
-    ev.add_timer(5000,
+    group.loop(0).add_timer(5000,
                  [](int timer_id) {
                  std::cout << "🎯 One-shot timer triggered! (ID: " << timer_id << ")" << std::endl;
-                 std::cout << "💡 You can connect with: telnet localhost 8080" << std::endl;
+                 std::cout << "💡 You can connect with: telnet localhost 9000" << std::endl;
                  }, false);
 
-    std::cout << "Starting event loop..." << std::endl;
+    // Signals arrive as events on loop 0, so the handlers may do anything a
+    // loop callback can. They are added before the loop threads exist so
+    // every thread inherits the blocked mask.
+    auto on_stop = [&group](int signo, uint32_t count) {
+        (void)count;
+        std::cout << "\nReceived " << strsignal(signo) << ", stopping event loops..." << std::endl;
+        group.stop();
+    };
+    group.loop(0).add_signal(SIGINT, on_stop);
+    group.loop(0).add_signal(SIGTERM, on_stop);
+    group.loop(0).add_signal(SIGHUP, [&heartbeat](int signo, uint32_t count) {
+        (void)signo;
+        std::cout << "Received SIGHUP (x" << count << "), reloading..." << std::endl;
+        heartbeat.change_interval(2000);
+    });
+
+    std::cout << "Starting event loops..." << std::endl;
     std::cout << "Heartbeat service running every 2 seconds" << std::endl;
 
-    ev.run(10000);
-    std::cout << "Event loop stopped." << std::endl;
+    group.start(10000);
+    group.join();
+    std::cout << "Event loops stopped." << std::endl;
 
     return 0;
 }
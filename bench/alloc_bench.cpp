@@ -0,0 +1,99 @@
+#include "evloop.h"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <unistd.h>
+#include <sys/socket.h>
+#include "bench_util.h"
+
+static std::atomic<size_t> g_allocs{0};
+
+void* operator new(size_t size) {
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    void* ptr = malloc(size ? size : 1);
+    if (!ptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void operator delete(void* ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete(void* ptr, size_t size) noexcept {
+    (void)size;
+    free(ptr);
+}
+
+// One accepted connection as the demo server sees it: an fd handler, a stats
+// timer and an idle timeout, one read, then teardown.
+static bool churn_once(LocalEvLoop& ev, uint64_t& reads) {
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds) < 0) {
+        perror("socketpair");
+        return false;
+    }
+
+    ev.add(fds[0], POLLIN, [&reads](int fd, short events, short revents) {
+        (void)events;
+        (void)revents;
+        char buf[16];
+        if (read(fd, buf, sizeof(buf)) > 0) {
+            reads++;
+        }
+    });
+    int stats_id = ev.add_timer(3000, [&reads](int timer_id) { (void)timer_id; reads++; },
+                                true, TimerMode::WHEEL);
+    int idle_id = ev.add_timer(30000, [&reads, fd = fds[0]](int timer_id) {
+        (void)timer_id;
+        (void)fd;
+        reads++;
+    }, false, TimerMode::WHEEL);
+
+    if (write(fds[1], "x", 1) != 1) {
+        perror("write");
+    }
+    ev.poll(0);
+
+    ev.remove_timer(stats_id);
+    ev.remove_timer(idle_id);
+    ev.remove(fds[0]);
+    close(fds[0]);
+    close(fds[1]);
+    return true;
+}
+
+static void run(BackendType type, size_t count) {
+    LocalEvLoop ev(type);
+    uint64_t reads = 0;
+
+    for (size_t i = 0; i < 1000; i++) {
+        churn_once(ev, reads);
+    }
+
+    reads = 0;
+    size_t before = g_allocs.load(std::memory_order_relaxed);
+    auto start = Clock::now();
+    for (size_t i = 0; i < count; i++) {
+        if (!churn_once(ev, reads)) {
+            return;
+        }
+    }
+    double secs = seconds_since(start);
+    size_t allocs = g_allocs.load(std::memory_order_relaxed) - before;
+
+    JsonLine("alloc").field("op", "connection_churn").field("backend", backend_name(type))
+        .field("ops", count).field("reads", reads).field("allocs", allocs)
+        .field("allocs_per_op", static_cast<double>(allocs) / count)
+        .field("seconds", secs, 6).field("ops_per_sec", count / secs, 0).print();
+}
+
+int main(int argc, char* argv[]) {
+    size_t count = argc > 1 ? std::stoul(argv[1]) : 100000;
+    for (auto type : {BackendType::POLL, BackendType::EPOLL, BackendType::URING}) {
+        run(type, count);
+    }
+    return 0;
+}
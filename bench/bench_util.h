@@ -0,0 +1,103 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "backend.h"
+
+// Shared helpers for the benchmarks. Every result is printed as one JSON
+// object per line so runs can be diffed and tracked between versions.
+
+using Clock = std::chrono::steady_clock;
+
+inline double seconds_since(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+inline const char* backend_name(BackendType type) {
+    switch (type) {
+    case BackendType::POLL:
+        return "poll";
+    case BackendType::EPOLL:
+        return "epoll";
+    default:
+        return "uring";
+    }
+}
+
+// Expects samples sorted ascending, in nanoseconds.
+inline double percentile_us(const std::vector<int64_t>& sorted, double p) {
+    if (sorted.empty()) {
+        return 0;
+    }
+    size_t index = std::min(sorted.size() - 1, static_cast<size_t>(p * sorted.size()));
+    return sorted[index] / 1000.0;
+}
+
+class JsonLine {
+public:
+    explicit JsonLine(const char* bench) {
+        add_key("bench");
+        add_string(bench);
+    }
+
+    JsonLine& field(const char* key, const char* value) {
+        add_key(key);
+        add_string(value);
+        return *this;
+    }
+
+    JsonLine& field(const char* key, uint64_t value) {
+        add_key(key);
+        out_ += std::to_string(value);
+        return *this;
+    }
+
+    JsonLine& field(const char* key, int value) {
+        add_key(key);
+        out_ += std::to_string(value);
+        return *this;
+    }
+
+    JsonLine& field(const char* key, double value, int precision = 3) {
+        char buf[64];
+        snprintf(buf, sizeof(buf), "%.*f", precision, value);
+        add_key(key);
+        out_ += buf;
+        return *this;
+    }
+
+    // Adds p50/p99/p999/max in microseconds for a set of nanosecond samples.
+    JsonLine& percentiles(std::vector<int64_t>& samples) {
+        std::sort(samples.begin(), samples.end());
+        field("p50_us", percentile_us(samples, 0.5), 1);
+        field("p99_us", percentile_us(samples, 0.99), 1);
+        field("p999_us", percentile_us(samples, 0.999), 1);
+        return field("max_us", samples.empty() ? 0.0 : samples.back() / 1000.0, 1);
+    }
+
+    void print() {
+        printf("%s}\n", out_.c_str());
+        fflush(stdout);
+    }
+
+private:
+    std::string out_{"{"};
+
+    void add_key(const char* key) {
+        if (out_.size() > 1) {
+            out_ += ",";
+        }
+        add_string(key);
+        out_ += ":";
+    }
+
+    void add_string(const char* value) {
+        out_ += "\"";
+        out_ += value;
+        out_ += "\"";
+    }
+};
@@ -0,0 +1,64 @@
+#include "evloop.h"
+#include <string>
+#include <thread>
+#include "bench_util.h"
+
+// Round trip of submit_blocking(): the time from submitting a job with a
+// spin of work_us until its completion runs on the loop. in_flight jobs are
+// kept outstanding; each completion submits the next one.
+static void run(BackendType type, size_t threads, size_t in_flight, int work_us, size_t jobs) {
+    BlockingPool pool(threads);
+    LocalEvLoop ev(type);
+    ev.set_blocking_pool(pool);
+    std::vector<int64_t> latency;
+    latency.reserve(jobs);
+    size_t submitted = 0;
+
+    auto work = [work_us]() {
+        auto until = Clock::now() + std::chrono::microseconds(work_us);
+        while (Clock::now() < until) {
+        }
+    };
+    std::function<void()> submit_next = [&]() {
+        if (submitted == jobs) {
+            return;
+        }
+        submitted++;
+        auto start = Clock::now();
+        ev.submit_blocking(work, [&, start]() {
+            latency.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                Clock::now() - start).count());
+            if (latency.size() == jobs) {
+                ev.stop();
+                return;
+            }
+            submit_next();
+        });
+    };
+    ev.post([&]() {
+        for (size_t i = 0; i < in_flight; i++) {
+            submit_next();
+        }
+    });
+
+    auto start = Clock::now();
+    ev.run(-1);
+    double secs = seconds_since(start);
+
+    BlockingPoolStats stats = pool.get_stats();
+    JsonLine("blocking").field("backend", backend_name(type)).field("threads", threads)
+        .field("in_flight", in_flight).field("work_us", work_us).field("jobs", latency.size())
+        .field("jobs_per_sec", latency.size() / secs, 0).field("max_depth", stats.max_depth)
+        .field("stolen", stats.stolen).percentiles(latency).print();
+}
+
+int main(int argc, char* argv[]) {
+    size_t jobs = argc > 1 ? std::stoul(argv[1]) : 20000;
+    size_t threads = std::max(2u, std::thread::hardware_concurrency());
+    for (auto type : {BackendType::POLL, BackendType::EPOLL, BackendType::URING}) {
+        run(type, threads, 1, 0, jobs);
+        run(type, threads, 64, 0, jobs * 5);
+        run(type, threads, 64, 20, jobs);
+    }
+    return 0;
+}
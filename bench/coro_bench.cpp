@@ -0,0 +1,166 @@
+#include "coro.h"
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <unistd.h>
+#include <sys/socket.h>
+#include "bench_util.h"
+
+static const size_t MESSAGE = 64;
+
+// Ping-pong of MESSAGE bytes over a socketpair, both ends on one loop,
+// driven either by data callbacks or by one coroutine per end.
+static void pingpong(BackendType type, bool coroutine, size_t rounds) {
+    LocalEvLoop ev(type);
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, sv) < 0) {
+        perror("socketpair");
+        return;
+    }
+    auto client = std::make_shared<LocalConnection>(ev, sv[0]);
+    auto server = std::make_shared<LocalConnection>(ev, sv[1]);
+    char message[MESSAGE];
+    memset(message, 'x', sizeof(message));
+    size_t done = 0;
+
+    if (coroutine) {
+        auto echo = [](LocalConnection& conn) -> Task<> {
+            char buf[4096];
+            size_t n;
+            while ((n = co_await read(conn, buf, sizeof(buf))) > 0) {
+                conn.send(buf, n);
+            }
+        };
+        auto drive = [&](LocalConnection& conn) -> Task<> {
+            char buf[MESSAGE];
+            for (; done < rounds; done++) {
+                conn.send(message, sizeof(message));
+                for (size_t got = 0; got < MESSAGE;) {
+                    size_t n = co_await read(conn, buf + got, MESSAGE - got);
+                    if (n == 0) {
+                        co_return;
+                    }
+                    got += n;
+                }
+            }
+            ev.stop();
+        };
+        ev.post([&]() {
+            spawn(echo(*server));
+            spawn(drive(*client));
+        });
+    } else {
+        server->set_data_callback([](LocalConnection& conn, ChainBuffer& input) {
+            while (!input.empty()) {
+                std::string_view chunk = input.front();
+                conn.send(chunk);
+                input.consume(chunk.size());
+            }
+        });
+        client->set_data_callback([&](LocalConnection& conn, ChainBuffer& input) {
+            while (input.size() >= MESSAGE) {
+                input.consume(MESSAGE);
+                if (++done == rounds) {
+                    ev.stop();
+                    return;
+                }
+                conn.send(message, sizeof(message));
+            }
+        });
+        ev.post([&]() { client->send(message, sizeof(message)); });
+    }
+    client->start();
+    server->start();
+
+    auto start = Clock::now();
+    ev.run(-1);
+    double secs = seconds_since(start);
+    client->close();
+    server->close();
+
+    JsonLine("coro").field("backend", backend_name(type)).field("case", "pingpong")
+        .field("mode", coroutine ? "coroutine" : "callback").field("rounds", done)
+        .field("ns_per_round", secs * 1e9 / rounds, 1).print();
+}
+
+// A task that re-posts itself against a coroutine awaiting post_to in a loop.
+static void hop(BackendType type, bool coroutine, size_t rounds) {
+    LocalEvLoop ev(type);
+    size_t done = 0;
+    std::function<void()> step;
+    if (coroutine) {
+        auto loop = [&]() -> Task<> {
+            while (++done < rounds) {
+                co_await post_to(ev);
+            }
+            ev.stop();
+        };
+        ev.post([&]() { spawn(loop()); });
+    } else {
+        step = [&]() {
+            if (++done == rounds) {
+                ev.stop();
+                return;
+            }
+            ev.post([&step]() { step(); });
+        };
+        ev.post([&step]() { step(); });
+    }
+
+    auto start = Clock::now();
+    ev.run(-1);
+    double secs = seconds_since(start);
+    JsonLine("coro").field("backend", backend_name(type)).field("case", "hop")
+        .field("mode", coroutine ? "coroutine" : "callback").field("rounds", done)
+        .field("ns_per_round", secs * 1e9 / rounds, 1).print();
+}
+
+static Task<int> child(int value) {
+    co_return value + 1;
+}
+
+static Task<> parent(uint64_t& sum) {
+    sum += co_await child(1);
+}
+
+// Spawns short tasks that await a child, so each one allocates two frames.
+// On the loop thread they come from the loop's FramePool; before run()
+// there is no current pool and they go to operator new.
+static void frames(bool pooled, size_t count) {
+    LocalEvLoop ev(BackendType::POLL);
+    uint64_t sum = 0;
+    double secs = 0;
+    auto spawn_all = [&]() {
+        auto start = Clock::now();
+        for (size_t i = 0; i < count; i++) {
+            spawn(parent(sum));
+        }
+        secs = seconds_since(start);
+    };
+    if (pooled) {
+        ev.post([&]() {
+            spawn_all();
+            ev.stop();
+        });
+        ev.run(-1);
+    } else {
+        spawn_all();
+    }
+    JsonLine("coro").field("case", "frames").field("mode", pooled ? "pool" : "heap")
+        .field("tasks", static_cast<uint64_t>(sum / 2)).field("reused", ev.frame_pool().reused())
+        .field("ns_per_task", secs * 1e9 / count, 1).print();
+}
+
+int main(int argc, char* argv[]) {
+    size_t rounds = argc > 1 ? std::stoul(argv[1]) : 200000;
+    for (auto type : {BackendType::POLL, BackendType::EPOLL, BackendType::URING}) {
+        for (bool coroutine : {false, true}) {
+            pingpong(type, coroutine, rounds);
+            hop(type, coroutine, rounds * 5);
+        }
+    }
+    for (bool pooled : {false, true}) {
+        frames(pooled, rounds * 5);
+    }
+    return 0;
+}
@@ -0,0 +1,82 @@
+#include "evloop.h"
+#include <string>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include "bench_util.h"
+
+// Cost of one poll() pass with `idle` registered socketpairs that never
+// become ready and `active` ones that are readable on every pass. Active
+// callbacks leave their byte unread, like a paused reader, so level-triggered
+// readiness stays constant across iterations; edge-triggered fds are only
+// reported once.
+static void run(BackendType type, unsigned mode, size_t idle, size_t active, size_t iterations) {
+    LocalEvLoop ev(type);
+    std::vector<int> fds;
+    fds.reserve((idle + active) * 2);
+    uint64_t callbacks = 0;
+
+    for (size_t i = 0; i < idle + active; i++) {
+        int pair[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, pair) < 0) {
+            perror("socketpair");
+            break;
+        }
+        fds.push_back(pair[0]);
+        fds.push_back(pair[1]);
+        ev.add(pair[0], POLLIN, [&callbacks](int fd, short events, short revents) {
+            (void)fd;
+            (void)events;
+            (void)revents;
+            callbacks++;
+        }, mode);
+        if (i >= idle && write(pair[1], "x", 1) != 1) {
+            perror("write");
+        }
+    }
+
+    for (size_t i = 0; i < 100; i++) {
+        ev.poll(0);
+    }
+    callbacks = 0;
+
+    auto start = Clock::now();
+    for (size_t i = 0; i < iterations; i++) {
+        ev.poll(0);
+    }
+    double secs = seconds_since(start);
+
+    JsonLine("dispatch").field("backend", backend_name(type))
+        .field("mode", mode == POLL_EDGE ? "edge" : "level").field("idle", idle)
+        .field("active", active).field("iterations", iterations).field("callbacks", callbacks)
+        .field("ns_per_poll", secs * 1e9 / iterations, 0)
+        .field("callbacks_per_sec", callbacks / secs, 0).print();
+
+    for (size_t i = 0; i < fds.size(); i += 2) {
+        ev.remove(fds[i]);
+    }
+    for (int fd : fds) {
+        close(fd);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    size_t iterations = argc > 1 ? std::stoul(argv[1]) : 2000;
+
+    rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+
+    for (auto type : {BackendType::POLL, BackendType::EPOLL, BackendType::URING}) {
+        for (unsigned mode : {POLL_LEVEL, POLL_EDGE}) {
+            for (size_t idle : {0, 100, 1000, 5000}) {
+                for (size_t active : {1, 16, 128}) {
+                    run(type, mode, idle, active, iterations);
+                }
+            }
+        }
+    }
+    return 0;
+}
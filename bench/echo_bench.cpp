@@ -0,0 +1,160 @@
+#include "evloop.h"
+#include <iostream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include "bench_util.h"
+
+static int create_listener(uint16_t& port) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        perror("socket");
+        return -1;
+    }
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ||
+        listen(fd, SOMAXCONN) < 0 ||
+        getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len) < 0) {
+        perror("listen");
+        close(fd);
+        return -1;
+    }
+    port = ntohs(addr.sin_port);
+    return fd;
+}
+
+static int connect_client(uint16_t port) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        perror("socket");
+        return -1;
+    }
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        perror("connect");
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static bool read_full(int fd, char* buf, size_t size) {
+    while (size > 0) {
+        ssize_t n = read(fd, buf, size);
+        if (n <= 0) {
+            return false;
+        }
+        buf += n;
+        size -= n;
+    }
+    return true;
+}
+
+// Echo server on its own loop thread. A client thread keeps `clients`
+// connections in lock step: it writes one message on each, then reads
+// every echo back, and times each round.
+static void run(BackendType type, size_t clients, size_t message, size_t rounds) {
+    LocalEvLoop ev(type);
+    uint16_t port = 0;
+    int listen_fd = create_listener(port);
+    if (listen_fd < 0) {
+        return;
+    }
+
+    auto echo = [](int fd, short events, short revents) {
+        (void)events;
+        (void)revents;
+        char buf[16384];
+        ssize_t n;
+        while ((n = read(fd, buf, sizeof(buf))) > 0) {
+            if (write(fd, buf, n) != n) {
+                perror("write");
+            }
+        }
+    };
+    std::vector<int> conns;
+    ev.add(listen_fd, POLLIN, [&ev, &conns, echo](int fd, short events, short revents) {
+        (void)events;
+        (void)revents;
+        int conn;
+        while ((conn = accept4(fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+            int one = 1;
+            setsockopt(conn, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            conns.push_back(conn);
+            ev.add(conn, POLLIN, echo);
+        }
+    });
+    std::thread loop_thread([&ev]() { ev.run(-1); });
+
+    std::vector<int> fds;
+    for (size_t i = 0; i < clients; i++) {
+        int fd = connect_client(port);
+        if (fd >= 0) {
+            fds.push_back(fd);
+        }
+    }
+
+    std::string out(message, 'x');
+    std::vector<char> in(message);
+    std::vector<int64_t> round_ns;
+    round_ns.reserve(rounds);
+    bool ok = fds.size() == clients;
+
+    auto start = Clock::now();
+    for (size_t r = 0; r < rounds && ok; r++) {
+        auto sent = Clock::now();
+        for (int fd : fds) {
+            ok = ok && write(fd, out.data(), message) == static_cast<ssize_t>(message);
+        }
+        for (int fd : fds) {
+            ok = ok && read_full(fd, in.data(), message);
+        }
+        round_ns.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            Clock::now() - sent).count());
+    }
+    double secs = seconds_since(start);
+
+    ev.post([&ev]() { ev.stop(); });
+    loop_thread.join();
+    for (int fd : conns) {
+        ev.remove(fd);
+        close(fd);
+    }
+    for (int fd : fds) {
+        close(fd);
+    }
+    ev.remove(listen_fd);
+    close(listen_fd);
+
+    if (!ok) {
+        std::cerr << "echo bench failed on " << backend_name(type) << std::endl;
+        return;
+    }
+    size_t round_trips = round_ns.size() * clients;
+    JsonLine("echo").field("backend", backend_name(type)).field("clients", clients)
+        .field("message", message).field("round_trips", round_trips)
+        .field("seconds", secs, 6).field("round_trips_per_sec", round_trips / secs, 0)
+        .field("mb_per_sec", round_trips * message * 2 / secs / 1e6, 1)
+        .percentiles(round_ns).print();
+}
+
+int main(int argc, char* argv[]) {
+    size_t rounds = argc > 1 ? std::stoul(argv[1]) : 20000;
+    for (auto type : {BackendType::POLL, BackendType::EPOLL, BackendType::URING}) {
+        run(type, 1, 64, rounds);
+        run(type, 16, 64, rounds / 16);
+        run(type, 1, 16384, rounds / 4);
+    }
+    return 0;
+}
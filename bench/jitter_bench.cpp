@@ -0,0 +1,44 @@
+#include "evloop.h"
+#include <string>
+#include "bench_util.h"
+
+// Re-arms a one-shot timer from its own callback and records how late each
+// expiry was dispatched relative to its deadline.
+static void run(BackendType type, std::chrono::nanoseconds interval, size_t samples) {
+    LocalEvLoop ev(type);
+    std::vector<int64_t> lateness;
+    lateness.reserve(samples);
+    Clock::time_point deadline;
+
+    std::function<void(int)> arm;
+    arm = [&](int timer_id) {
+        (void)timer_id;
+        auto now = Clock::now();
+        if (deadline != Clock::time_point()) {
+            lateness.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                now - deadline).count());
+        }
+        if (lateness.size() >= samples) {
+            ev.stop();
+            return;
+        }
+        deadline = Clock::now() + interval;
+        ev.add_timer(interval, [&arm](int id) { arm(id); }, false);
+    };
+    arm(0);
+    ev.run(1000);
+
+    JsonLine("jitter").field("backend", backend_name(type))
+        .field("interval_us", static_cast<uint64_t>(interval.count() / 1000))
+        .field("samples", lateness.size()).percentiles(lateness).print();
+}
+
+int main(int argc, char* argv[]) {
+    size_t samples = argc > 1 ? std::stoul(argv[1]) : 5000;
+    for (auto type : {BackendType::POLL, BackendType::EPOLL, BackendType::URING}) {
+        for (long us : {50, 100, 200, 1000}) {
+            run(type, std::chrono::microseconds(us), samples);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,72 @@
+#include "timer.h"
+#include <iostream>
+#include <random>
+#include <thread>
+#include "bench_util.h"
+
+class BenchTimer: public Timer {
+public:
+    using Timer::process_timers;
+};
+
+static void report(const char* op, size_t timers, size_t ops, double secs) {
+    JsonLine("timer").field("op", op).field("timers", timers).field("ops", ops)
+        .field("seconds", secs, 6).field("ops_per_sec", ops / secs, 0).print();
+}
+
+static void run(size_t count) {
+    BenchTimer timer;
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> interval(1000, 100000);
+    std::vector<int> ids;
+    ids.reserve(count);
+    uint64_t fired = 0;
+    auto callback = [&fired](int timer_id) { (void)timer_id; fired++; };
+
+    auto start = Clock::now();
+    for (size_t i = 0; i < count; i++) {
+        ids.push_back(timer.add_timer(interval(rng), callback, true));
+    }
+    report("add", count, count, seconds_since(start));
+
+    size_t updates = std::min<size_t>(count, 100000);
+    std::uniform_int_distribution<size_t> pick(0, count - 1);
+    start = Clock::now();
+    for (size_t i = 0; i < updates; i++) {
+        timer.update_timer_interval(ids[pick(rng)], interval(rng));
+    }
+    report("reschedule", count, updates, seconds_since(start));
+
+    size_t churn = std::min<size_t>(count, 100000);
+    start = Clock::now();
+    for (size_t i = 0; i < churn; i++) {
+        size_t slot = pick(rng);
+        timer.remove_timer(ids[slot]);
+        ids[slot] = timer.add_timer(interval(rng), callback, true);
+    }
+    report("cancel_add", count, churn * 2, seconds_since(start));
+
+    size_t shots = std::min<size_t>(count, 100000);
+    for (size_t i = 0; i < shots; i++) {
+        timer.add_timer(1, callback, false);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    start = Clock::now();
+    timer.process_timers();
+    report("fire", count, fired, seconds_since(start));
+
+    std::shuffle(ids.begin(), ids.end(), rng);
+    start = Clock::now();
+    for (int id : ids) {
+        timer.remove_timer(id);
+    }
+    report("cancel", count, count, seconds_since(start));
+}
+
+int main(int argc, char* argv[]) {
+    size_t max_count = argc > 1 ? std::stoul(argv[1]) : 1000000;
+    for (size_t count = 1000; count <= max_count; count *= 10) {
+        run(count);
+    }
+    return 0;
+}
@@ -0,0 +1,137 @@
+#include "evloop.h"
+#include "udp_endpoint.h"
+#include <atomic>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include "bench_util.h"
+
+static sockaddr_in loopback(int port) {
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    return addr;
+}
+
+// Receive side of one run: either a UdpEndpoint, or the baseline that reads
+// one datagram per wakeup with recvfrom.
+struct Receiver {
+    std::atomic<uint64_t> packets{0};
+    Clock::time_point first;
+    Clock::time_point last;
+
+    void count(size_t n) {
+        auto now = Clock::now();
+        if (packets.load(std::memory_order_relaxed) == 0) {
+            first = now;
+        }
+        last = now;
+        packets.store(packets.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+};
+
+// A sender endpoint on the main thread floods a receiver on its own loop
+// thread over loopback; rate is measured between the first and the last
+// datagram received.
+static void run(BackendType type, const char* mode, size_t payload, size_t count) {
+    bool single = std::string(mode) == "single";
+    bool offload = std::string(mode) == "offload";
+    LocalEvLoop ev(type);
+    Receiver receiver;
+    LocalUdpEndpoint endpoint(ev);
+    int rx_fd = -1;
+    int rx_port = 0;
+
+    if (single) {
+        rx_fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        sockaddr_in addr = loopback(0);
+        socklen_t len = sizeof(addr);
+        if (bind(rx_fd, (sockaddr*)&addr, sizeof(addr)) < 0 ||
+            getsockname(rx_fd, (sockaddr*)&addr, &len) < 0) {
+            perror("bind");
+            return;
+        }
+        rx_port = ntohs(addr.sin_port);
+        ev.add(rx_fd, POLLIN, [&receiver](int fd, short events, short revents) {
+            (void)events;
+            (void)revents;
+            char buf[2048];
+            if (recvfrom(fd, buf, sizeof(buf), 0, nullptr, nullptr) >= 0) {
+                receiver.count(1);
+            }
+        });
+    } else {
+        auto on_receive = [&receiver](const LocalUdpEndpoint::Datagram* datagrams, size_t n) {
+            (void)datagrams;
+            receiver.count(n);
+        };
+        if (!endpoint.open(0, on_receive, "127.0.0.1", offload)) {
+            return;
+        }
+        rx_fd = endpoint.fd();
+        rx_port = endpoint.port();
+    }
+    int rcvbuf = 8 << 20;
+    setsockopt(rx_fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+
+    std::thread loop_thread([&ev]() { ev.run(-1); });
+
+    LocalEvLoop sender_ev(type);
+    LocalUdpEndpoint sender(sender_ev);
+    if (!sender.open(0, [](const LocalUdpEndpoint::Datagram*, size_t) {}, "127.0.0.1", offload)) {
+        ev.post([&ev]() { ev.stop(); });
+        loop_thread.join();
+        return;
+    }
+    std::string data(payload, 'x');
+    sockaddr_in peer = loopback(rx_port);
+    auto start = Clock::now();
+    for (size_t i = 0; i < count; i++) {
+        // Waits out a full socket buffer rather than dropping.
+        while (sender.queued() == LocalUdpEndpoint::DEFAULT_BATCH) {
+            sender.flush();
+            if (sender.queued() == LocalUdpEndpoint::DEFAULT_BATCH) {
+                std::this_thread::yield();
+            }
+        }
+        sender.send(data.data(), data.size(), peer);
+    }
+    while (sender.queued() > 0) {
+        sender.flush();
+        std::this_thread::yield();
+    }
+    double send_secs = seconds_since(start);
+
+    // Give the receiver time to drain what is still queued.
+    uint64_t seen = 0;
+    while (receiver.packets.load() != seen) {
+        seen = receiver.packets.load();
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    ev.post([&ev]() { ev.stop(); });
+    loop_thread.join();
+    if (single) {
+        ev.remove(rx_fd);
+        close(rx_fd);
+    }
+
+    double recv_secs = std::chrono::duration<double>(receiver.last - receiver.first).count();
+    uint64_t received = receiver.packets.load();
+    JsonLine("udp").field("backend", backend_name(type)).field("mode", mode)
+        .field("payload", payload).field("sent", sender.sent()).field("received", received)
+        .field("gso", static_cast<int>(sender.gso())).field("gro", static_cast<int>(endpoint.gro()))
+        .field("send_pps", sender.sent() / send_secs, 0)
+        .field("recv_pps", recv_secs > 0 ? received / recv_secs : 0.0, 0).print();
+}
+
+int main(int argc, char* argv[]) {
+    size_t count = argc > 1 ? std::stoul(argv[1]) : 500000;
+    for (auto type : {BackendType::POLL, BackendType::EPOLL, BackendType::URING}) {
+        for (const char* mode : {"single", "batch", "offload"}) {
+            run(type, mode, 64, count);
+            run(type, mode, 1200, count);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,50 @@
+#include "evloop.h"
+#include <atomic>
+#include <string>
+#include <thread>
+#include "bench_util.h"
+
+// Measures how long a task posted from another thread takes to start
+// running on a loop that is blocked in its wait. Every post goes through
+// trigger_loop(); the producer waits for each task to finish and gives the
+// loop time to block again so that no wakeup is coalesced.
+template <typename Loop>
+static void run(const char* lock, BackendType type, size_t samples) {
+    Loop ev(type);
+    std::vector<int64_t> latency;
+    latency.reserve(samples);
+    std::atomic<size_t> done{0};
+
+    std::thread loop_thread([&ev]() { ev.run(-1); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    auto start = Clock::now();
+    for (size_t i = 0; i < samples; i++) {
+        auto posted = Clock::now();
+        ev.post([&latency, &done, posted]() {
+            latency.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                Clock::now() - posted).count());
+            done.store(done.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        });
+        while (done.load(std::memory_order_acquire) <= i) {
+            std::this_thread::yield();
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(20));
+    }
+    double secs = seconds_since(start);
+
+    ev.post([&ev]() { ev.stop(); });
+    loop_thread.join();
+
+    JsonLine("wakeup").field("backend", backend_name(type)).field("lock", lock)
+        .field("samples", latency.size()).field("seconds", secs, 6).percentiles(latency).print();
+}
+
+int main(int argc, char* argv[]) {
+    size_t samples = argc > 1 ? std::stoul(argv[1]) : 10000;
+    for (auto type : {BackendType::POLL, BackendType::EPOLL, BackendType::URING}) {
+        run<EvLoop>("thread_safe", type, samples);
+        run<LocalEvLoop>("local", type, samples);
+    }
+    return 0;
+}
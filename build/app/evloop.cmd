@@ -0,0 +1 @@
+g++ /root/repo/build/app/.evloop/main.o /root/repo/build/app/.evloop/../src/evloop.o /root/repo/build/app/.evloop/../src/timer.o /root/repo/build/app/.evloop/../src/poller.o /root/repo/build/app/.evloop/../src/backend.o /root/repo/build/app/.evloop/../src/uring.o /root/repo/build/app/.evloop/../src/evloop_group.o /root/repo/build/app/.evloop/../src/loop_stats.o /root/repo/build/app/.evloop/../src/watchdog.o /root/repo/build/app/.evloop/../src/frame_pool.o /root/repo/build/app/.evloop/../src/chain_buffer.o /root/repo/build/app/.evloop/../src/connection.o /root/repo/build/app/.evloop/../src/acceptor.o /root/repo/build/app/.evloop/../src/blocking_pool.o -o /root/repo/build/app/evloop   -L.  -L./  
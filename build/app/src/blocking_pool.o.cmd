@@ -0,0 +1 @@
+g++ -Wall -Wextra -Werror -pipe -g3 -O2 -fsigned-char -fno-strict-aliasing -fPIC -Werror=unused-result   -I. -I../src/  -c ../src/blocking_pool.cpp -o /root/repo/build/app/.evloop/../src/blocking_pool.o
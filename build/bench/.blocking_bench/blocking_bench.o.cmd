@@ -0,0 +1 @@
+g++ -Wall -Wextra -Werror -pipe -g3 -O2 -fsigned-char -fno-strict-aliasing -fPIC -Werror=unused-result   -I. -I../src/  -c blocking_bench.cpp -o /root/repo/build/bench/.blocking_bench/blocking_bench.o
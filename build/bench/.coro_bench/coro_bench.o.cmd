@@ -0,0 +1 @@
+g++ -Wall -Wextra -Werror -pipe -g3 -O2 -fsigned-char -fno-strict-aliasing -fPIC -Werror=unused-result   -I. -I../src/ -std=c++20  -c coro_bench.cpp -o /root/repo/build/bench/.coro_bench/coro_bench.o
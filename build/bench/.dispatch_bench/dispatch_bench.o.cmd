@@ -0,0 +1 @@
+g++ -Wall -Wextra -Werror -pipe -g3 -O2 -fsigned-char -fno-strict-aliasing -fPIC -Werror=unused-result   -I. -I../src/  -c dispatch_bench.cpp -o /root/repo/build/bench/.dispatch_bench/dispatch_bench.o
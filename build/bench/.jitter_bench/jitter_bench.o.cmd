@@ -0,0 +1 @@
+g++ -Wall -Wextra -Werror -pipe -g3 -O2 -fsigned-char -fno-strict-aliasing -fPIC -Werror=unused-result   -I. -I../src/  -c jitter_bench.cpp -o /root/repo/build/bench/.jitter_bench/jitter_bench.o
@@ -0,0 +1 @@
+g++ /root/repo/build/bench/.blocking_bench/blocking_bench.o /root/repo/build/bench/.blocking_bench/../src/evloop.o /root/repo/build/bench/.blocking_bench/../src/timer.o /root/repo/build/bench/.blocking_bench/../src/poller.o /root/repo/build/bench/.blocking_bench/../src/backend.o /root/repo/build/bench/.blocking_bench/../src/uring.o /root/repo/build/bench/.blocking_bench/../src/loop_stats.o /root/repo/build/bench/.blocking_bench/../src/watchdog.o /root/repo/build/bench/.blocking_bench/../src/frame_pool.o /root/repo/build/bench/.blocking_bench/../src/chain_buffer.o /root/repo/build/bench/.blocking_bench/../src/connection.o /root/repo/build/bench/.blocking_bench/../src/blocking_pool.o -o /root/repo/build/bench/blocking_bench   -L.  -L./  
@@ -0,0 +1 @@
+g++ /root/repo/build/bench/.coro_bench/coro_bench.o /root/repo/build/bench/.coro_bench/../src/evloop.o /root/repo/build/bench/.coro_bench/../src/timer.o /root/repo/build/bench/.coro_bench/../src/poller.o /root/repo/build/bench/.coro_bench/../src/backend.o /root/repo/build/bench/.coro_bench/../src/uring.o /root/repo/build/bench/.coro_bench/../src/loop_stats.o /root/repo/build/bench/.coro_bench/../src/watchdog.o /root/repo/build/bench/.coro_bench/../src/frame_pool.o /root/repo/build/bench/.coro_bench/../src/chain_buffer.o /root/repo/build/bench/.coro_bench/../src/connection.o /root/repo/build/bench/.coro_bench/../src/blocking_pool.o -o /root/repo/build/bench/coro_bench   -L.  -L./  
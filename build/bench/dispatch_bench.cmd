@@ -0,0 +1 @@
+g++ /root/repo/build/bench/.dispatch_bench/dispatch_bench.o /root/repo/build/bench/.dispatch_bench/../src/evloop.o /root/repo/build/bench/.dispatch_bench/../src/timer.o /root/repo/build/bench/.dispatch_bench/../src/poller.o /root/repo/build/bench/.dispatch_bench/../src/backend.o /root/repo/build/bench/.dispatch_bench/../src/uring.o /root/repo/build/bench/.dispatch_bench/../src/loop_stats.o /root/repo/build/bench/.dispatch_bench/../src/watchdog.o /root/repo/build/bench/.dispatch_bench/../src/frame_pool.o /root/repo/build/bench/.dispatch_bench/../src/chain_buffer.o /root/repo/build/bench/.dispatch_bench/../src/connection.o /root/repo/build/bench/.dispatch_bench/../src/blocking_pool.o -o /root/repo/build/bench/dispatch_bench   -L.  -L./  
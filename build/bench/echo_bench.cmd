@@ -0,0 +1 @@
+g++ /root/repo/build/bench/.echo_bench/echo_bench.o /root/repo/build/bench/.echo_bench/../src/evloop.o /root/repo/build/bench/.echo_bench/../src/timer.o /root/repo/build/bench/.echo_bench/../src/poller.o /root/repo/build/bench/.echo_bench/../src/backend.o /root/repo/build/bench/.echo_bench/../src/uring.o /root/repo/build/bench/.echo_bench/../src/loop_stats.o /root/repo/build/bench/.echo_bench/../src/watchdog.o /root/repo/build/bench/.echo_bench/../src/frame_pool.o /root/repo/build/bench/.echo_bench/../src/chain_buffer.o /root/repo/build/bench/.echo_bench/../src/connection.o /root/repo/build/bench/.echo_bench/../src/blocking_pool.o -o /root/repo/build/bench/echo_bench   -L.  -L./  
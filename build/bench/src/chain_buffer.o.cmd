@@ -0,0 +1 @@
+g++ -Wall -Wextra -Werror -pipe -g3 -O2 -fsigned-char -fno-strict-aliasing -fPIC -Werror=unused-result   -I. -I../src/  -c ../src/chain_buffer.cpp -o /root/repo/build/bench/.alloc_bench/../src/chain_buffer.o
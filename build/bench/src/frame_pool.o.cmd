@@ -0,0 +1 @@
+g++ -Wall -Wextra -Werror -pipe -g3 -O2 -fsigned-char -fno-strict-aliasing -fPIC -Werror=unused-result   -I. -I../src/  -c ../src/frame_pool.cpp -o /root/repo/build/bench/.alloc_bench/../src/frame_pool.o
@@ -0,0 +1 @@
+g++ -Wall -Wextra -Werror -pipe -g3 -O2 -fsigned-char -fno-strict-aliasing -fPIC -Werror=unused-result   -I. -I../src/  -c ../src/loop_stats.cpp -o /root/repo/build/bench/.alloc_bench/../src/loop_stats.o
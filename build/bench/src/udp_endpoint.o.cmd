@@ -0,0 +1 @@
+g++ -Wall -Wextra -Werror -pipe -g3 -O2 -fsigned-char -fno-strict-aliasing -fPIC -Werror=unused-result   -I. -I../src/  -c ../src/udp_endpoint.cpp -o /root/repo/build/bench/.udp_bench/../src/udp_endpoint.o
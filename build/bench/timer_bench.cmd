@@ -0,0 +1 @@
+g++ /root/repo/build/bench/.timer_bench/timer_bench.o /root/repo/build/bench/.timer_bench/../src/timer.o -o /root/repo/build/bench/timer_bench   -L.  -L./  
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <sys/socket.h>
+#include "poller.h"
+
+// Listening TCP socket on a Poller. Each wakeup accepts up to a budget of
+// connections with accept4, which hands them over already non-blocking and
+// close-on-exec. When the process runs out of fds, a reserved fd is given
+// up to accept and close the pending connection, so the backlog keeps
+// draining instead of the listener spinning on a readiness it cannot
+// consume.
+template <typename Lock>
+class BasicAcceptor {
+public:
+    using AcceptCallback = std::function<void(int fd)>;
+
+    static constexpr size_t DEFAULT_BUDGET = 64;
+
+    explicit BasicAcceptor(BasicPoller<Lock>& poller);
+    ~BasicAcceptor();
+
+    BasicAcceptor(const BasicAcceptor&) = delete;
+    BasicAcceptor& operator=(const BasicAcceptor&) = delete;
+
+    // Port 0 binds an ephemeral port, see port().
+    bool listen(int port, AcceptCallback callback, int backlog = SOMAXCONN,
+                bool reuseport = false);
+
+    // Connections accepted per wakeup before yielding to other fds. The
+    // level triggered backends report the listener again if more are queued.
+    void set_budget(size_t budget) { budget_ = budget ? budget : 1; }
+
+    void close();
+
+    int fd() const { return fd_; }
+
+    int port() const { return port_; }
+
+    uint64_t accepted() const { return accepted_; }
+
+    // Connections closed right away because no fd was available.
+    uint64_t dropped() const { return dropped_; }
+
+private:
+    BasicPoller<Lock>& poller_;
+    int fd_{-1};
+    int reserve_fd_{-1};
+    int port_{0};
+    size_t budget_{DEFAULT_BUDGET};
+    uint64_t accepted_{0};
+    uint64_t dropped_{0};
+    AcceptCallback callback_;
+
+    void handle_accept();
+
+    void drop_pending();
+};
+
+using Acceptor = BasicAcceptor<ThreadSafe>;
+using LocalAcceptor = BasicAcceptor<NoLock>;
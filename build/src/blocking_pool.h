@@ -0,0 +1,101 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Snapshot of a BlockingPool. Histogram bucket i counts values of bit width
+// i, as in LoopStats.
+struct BlockingPoolStats {
+    static constexpr size_t LATENCY_BUCKETS = 32;
+
+    size_t threads{0};
+    // Jobs queued and not yet picked up by a worker.
+    uint64_t depth{0};
+    uint64_t max_depth{0};
+    uint64_t submitted{0};
+    uint64_t completed{0};
+    // Jobs a worker took from another worker's queue.
+    uint64_t stolen{0};
+    // Time from submit() until a worker starts the job.
+    uint64_t queue_wait_us[LATENCY_BUCKETS]{};
+    uint64_t run_us[LATENCY_BUCKETS]{};
+    // Time from the job finishing until its completion ran on the loop.
+    uint64_t completion_us[LATENCY_BUCKETS]{};
+
+    std::string to_json() const;
+};
+
+// Worker threads for blocking work (file I/O, compression, hashing) that
+// must not run on a loop thread. Every worker has its own queue; submit()
+// spreads jobs across them and an idle worker steals from the others, so
+// one slow job only holds up its own queue. Loops share shared() unless
+// given a pool of their own.
+class BlockingPool {
+public:
+    using Job = std::function<void()>;
+    using Clock = std::chrono::steady_clock;
+
+    // 0 threads means one per CPU.
+    explicit BlockingPool(size_t threads = 0);
+    // Runs the jobs still queued, then joins the workers.
+    ~BlockingPool();
+
+    BlockingPool(const BlockingPool&) = delete;
+    BlockingPool& operator=(const BlockingPool&) = delete;
+
+    // Created on first use with one thread per CPU, at least two.
+    static BlockingPool& shared();
+
+    // Thread-safe. False once the pool is shutting down.
+    bool submit(Job job);
+
+    // Feeds completion_us; called by the loop running the completion.
+    void record_completion(Clock::duration delay);
+
+    size_t size() const { return workers_.size(); }
+
+    BlockingPoolStats get_stats() const;
+
+private:
+    struct Entry {
+        Job job;
+        Clock::time_point queued;
+    };
+
+    struct Worker {
+        std::mutex mtx;
+        std::deque<Entry> queue;
+        std::thread thread;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::atomic<size_t> next_{0};
+    std::atomic<uint64_t> depth_{0};
+    std::atomic<uint64_t> max_depth_{0};
+    std::atomic<uint64_t> submitted_{0};
+    std::atomic<uint64_t> completed_{0};
+    std::atomic<uint64_t> stolen_{0};
+    std::atomic<uint64_t> queue_wait_us_[BlockingPoolStats::LATENCY_BUCKETS]{};
+    std::atomic<uint64_t> run_us_[BlockingPoolStats::LATENCY_BUCKETS]{};
+    std::atomic<uint64_t> completion_us_[BlockingPoolStats::LATENCY_BUCKETS]{};
+    // Sleeping workers wait here until depth_ is non-zero.
+    std::mutex mtx;
+    std::condition_variable cv_;
+    size_t sleeping_{0};
+    std::atomic<bool> stop_{false};
+
+    void run_worker(size_t index);
+
+    bool take(size_t index, Entry& entry);
+
+    static void record(std::atomic<uint64_t>* buckets, Clock::duration elapsed);
+};
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <deque>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Byte queue made of fixed size chunks. Appending never moves bytes that
+// are already queued, reads from an fd go straight into free chunk space
+// and writes hand every queued chunk to one writev. Drained chunks are kept
+// for reuse, so a connection in steady state does not allocate.
+class ChainBuffer {
+public:
+    static constexpr size_t CHUNK_SIZE = 16384;
+    // Upper bound on the iovecs passed to a single writev.
+    static constexpr size_t MAX_IOV = 64;
+
+    ChainBuffer() = default;
+
+    ChainBuffer(const ChainBuffer&) = delete;
+    ChainBuffer& operator=(const ChainBuffer&) = delete;
+    ChainBuffer(ChainBuffer&&) = default;
+    ChainBuffer& operator=(ChainBuffer&&) = default;
+
+    size_t size() const { return size_; }
+
+    bool empty() const { return size_ == 0; }
+
+    void append(const void* data, size_t len);
+
+    void append(std::string_view data) { append(data.data(), data.size()); }
+
+    // The first contiguous run of queued bytes.
+    std::string_view front() const;
+
+    // Copies up to len bytes without consuming them.
+    size_t copy_to(void* dst, size_t len) const;
+
+    void consume(size_t len);
+
+    std::string take(size_t len);
+
+    std::string take_all() { return take(size_); }
+
+    void clear();
+
+    // Reads once into the free space of the last chunk plus one fresh chunk.
+    // Returns the byte count, 0 on EOF or -1 with errno set.
+    ssize_t read_fd(int fd);
+
+    // Writes as much as one writev accepts and consumes it. Sockets are
+    // written with MSG_NOSIGNAL. Returns the byte count or -1 with errno set.
+    ssize_t write_fd(int fd);
+
+private:
+    struct Chunk {
+        std::unique_ptr<char[]> data;
+        size_t begin{0};
+        size_t end{0};
+    };
+
+    // Drained chunks kept around for reuse.
+    static constexpr size_t MAX_SPARE = 4;
+
+    std::deque<Chunk> chunks_;
+    std::vector<std::unique_ptr<char[]>> spare_;
+    size_t size_{0};
+
+    Chunk make_chunk();
+
+    void release_front();
+};
@@ -0,0 +1,317 @@
+#pragma once
+
+#if !defined(__cpp_impl_coroutine)
+#error "coro.h needs C++20 coroutines, build with -std=c++20"
+#endif
+
+#include <chrono>
+#include <coroutine>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <utility>
+#include "evloop.h"
+#include "connection.h"
+#include "frame_pool.h"
+
+// Coroutines on top of EvLoop. A Task is lazy: it starts when awaited by
+// another task, or when handed to spawn(), which runs it detached until
+// its first suspension. The awaitables below resume the coroutine straight
+// from the loop's fd, timer or task callback, so a wait costs what the
+// equivalent hand-written callback does. Frames come from the current
+// loop's FramePool when the task is created on a running loop's thread.
+//
+// A suspended coroutine is only resumed by the event it waits for; it is
+// not destroyed with the loop, so loops should outlive their coroutines.
+
+template <typename T = void>
+class Task;
+
+class TaskPromiseBase {
+public:
+    static void* operator new(size_t size) { return FramePool::allocate(size); }
+
+    static void operator delete(void* ptr) noexcept { FramePool::deallocate(ptr); }
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+
+    // Hands control back to the awaiting coroutine, or frees a detached one.
+    struct FinalAwaiter {
+        bool await_ready() noexcept { return false; }
+
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+            TaskPromiseBase& promise = handle.promise();
+            if (!promise.detached_) {
+                return promise.continuation_ ? promise.continuation_ : std::noop_coroutine();
+            }
+            if (promise.error_) {
+                try {
+                    std::rethrow_exception(promise.error_);
+                } catch (const std::exception& e) {
+                    std::cerr << "Exception in coroutine: " << e.what() << std::endl;
+                } catch (...) {
+                    std::cerr << "Unknown exception in coroutine" << std::endl;
+                }
+            }
+            handle.destroy();
+            return std::noop_coroutine();
+        }
+
+        void await_resume() noexcept {}
+    };
+
+    FinalAwaiter final_suspend() noexcept { return {}; }
+
+    void unhandled_exception() noexcept { error_ = std::current_exception(); }
+
+protected:
+    std::coroutine_handle<> continuation_;
+    std::exception_ptr error_;
+    bool detached_{false};
+
+    template <typename T>
+    friend class Task;
+
+    friend void spawn(Task<void> task);
+};
+
+template <typename T>
+class TaskPromise: public TaskPromiseBase {
+public:
+    Task<T> get_return_object() noexcept;
+
+    template <typename U>
+    void return_value(U&& value) { value_.emplace(std::forward<U>(value)); }
+
+    T result() {
+        if (error_) {
+            std::rethrow_exception(error_);
+        }
+        return std::move(*value_);
+    }
+
+private:
+    std::optional<T> value_;
+};
+
+template <>
+class TaskPromise<void>: public TaskPromiseBase {
+public:
+    Task<void> get_return_object() noexcept;
+
+    void return_void() noexcept {}
+
+    void result() {
+        if (error_) {
+            std::rethrow_exception(error_);
+        }
+    }
+};
+
+template <typename T>
+class Task {
+public:
+    using promise_type = TaskPromise<T>;
+    using Handle = std::coroutine_handle<promise_type>;
+
+    Task() = default;
+
+    explicit Task(Handle handle) : handle_(handle) {}
+
+    ~Task() {
+        if (handle_) {
+            handle_.destroy();
+        }
+    }
+
+    Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (handle_) {
+                handle_.destroy();
+            }
+            handle_ = std::exchange(other.handle_, nullptr);
+        }
+        return *this;
+    }
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    bool done() const { return !handle_ || handle_.done(); }
+
+    // Starts the task and returns to the awaiting coroutine once it is done.
+    auto operator co_await() noexcept {
+        struct Awaiter {
+            Handle handle;
+
+            bool await_ready() const noexcept { return !handle || handle.done(); }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+                handle.promise().continuation_ = awaiting;
+                return handle;
+            }
+
+            T await_resume() { return handle.promise().result(); }
+        };
+        return Awaiter{handle_};
+    }
+
+private:
+    Handle handle_;
+
+    friend void spawn(Task<void> task);
+};
+
+template <typename T>
+Task<T> TaskPromise<T>::get_return_object() noexcept {
+    return Task<T>(Task<T>::Handle::from_promise(*this));
+}
+
+inline Task<void> TaskPromise<void>::get_return_object() noexcept {
+    return Task<void>(Task<void>::Handle::from_promise(*this));
+}
+
+// Runs task detached; its frame is freed when it finishes. Exceptions that
+// escape it are reported on stderr, like those of posted tasks.
+inline void spawn(Task<void> task) {
+    auto handle = std::exchange(task.handle_, nullptr);
+    if (handle) {
+        handle.promise().detached_ = true;
+        handle.resume();
+    }
+}
+
+// Waits until fd reports one of events, registering it with the poller for
+// the duration of the wait. The fd must not be registered otherwise.
+// Yields the revents, POLLNVAL if the fd could not be registered.
+template <typename Lock>
+class FdAwaiter {
+public:
+    FdAwaiter(BasicPoller<Lock>& poller, int fd, short events)
+        : poller_(poller), fd_(fd), events_(events) {}
+
+    bool await_ready() const noexcept { return false; }
+
+    bool await_suspend(std::coroutine_handle<> handle) {
+        auto callback = [this, handle](int fd, short events, short revents) {
+            (void)events;
+            poller_.remove(fd);
+            revents_ = revents;
+            handle.resume();
+        };
+        if (!poller_.add(fd_, events_, callback)) {
+            revents_ = POLLNVAL;
+            return false;
+        }
+        return true;
+    }
+
+    short await_resume() const noexcept { return revents_; }
+
+private:
+    BasicPoller<Lock>& poller_;
+    int fd_;
+    short events_;
+    short revents_{0};
+};
+
+template <typename Lock>
+FdAwaiter<Lock> readable(BasicPoller<Lock>& poller, int fd) {
+    return FdAwaiter<Lock>(poller, fd, POLLIN);
+}
+
+template <typename Lock>
+FdAwaiter<Lock> writable(BasicPoller<Lock>& poller, int fd) {
+    return FdAwaiter<Lock>(poller, fd, POLLOUT);
+}
+
+// Resumes after duration on a one-shot QUEUE timer.
+template <typename Lock>
+class SleepAwaiter {
+public:
+    SleepAwaiter(BasicEvLoop<Lock>& loop, std::chrono::nanoseconds duration)
+        : loop_(loop), duration_(duration) {}
+
+    bool await_ready() const noexcept { return duration_.count() <= 0; }
+
+    bool await_suspend(std::coroutine_handle<> handle) {
+        auto callback = [handle](int timer_id) {
+            (void)timer_id;
+            handle.resume();
+        };
+        return loop_.add_timer(duration_, callback, false) >= 0;
+    }
+
+    void await_resume() const noexcept {}
+
+private:
+    BasicEvLoop<Lock>& loop_;
+    std::chrono::nanoseconds duration_;
+};
+
+template <typename Lock>
+SleepAwaiter<Lock> sleep_for(BasicEvLoop<Lock>& loop, std::chrono::nanoseconds duration) {
+    return SleepAwaiter<Lock>(loop, duration);
+}
+
+// Continues the coroutine on loop's thread, from its next batch of posted
+// tasks. Awaiting the current loop yields to the rest of the iteration.
+template <typename Lock>
+class PostAwaiter {
+public:
+    explicit PostAwaiter(BasicEvLoop<Lock>& loop) : loop_(loop) {}
+
+    bool await_ready() const noexcept { return false; }
+
+    void await_suspend(std::coroutine_handle<> handle) {
+        loop_.post([handle]() { handle.resume(); });
+    }
+
+    void await_resume() const noexcept {}
+
+private:
+    BasicEvLoop<Lock>& loop_;
+};
+
+template <typename Lock>
+PostAwaiter<Lock> post_to(BasicEvLoop<Lock>& loop) {
+    return PostAwaiter<Lock>(loop);
+}
+
+// Copies up to len bytes of a started connection's input to buf, waiting
+// for data if none is buffered. Yields the byte count, 0 once the
+// connection is closed. The wait uses the connection's read waiter, so
+// input that arrives meanwhile skips the data callback, while the close
+// callback still runs.
+template <typename Lock>
+class ReadAwaiter {
+public:
+    ReadAwaiter(BasicConnection<Lock>& conn, void* buf, size_t len)
+        : conn_(conn), buf_(buf), len_(len) {}
+
+    bool await_ready() const noexcept { return !conn_.input().empty() || !conn_.is_open(); }
+
+    void await_suspend(std::coroutine_handle<> handle) {
+        conn_.set_read_waiter([handle]() { handle.resume(); });
+    }
+
+    size_t await_resume() {
+        ChainBuffer& input = conn_.input();
+        size_t n = input.copy_to(buf_, len_);
+        input.consume(n);
+        return n;
+    }
+
+private:
+    BasicConnection<Lock>& conn_;
+    void* buf_;
+    size_t len_;
+};
+
+template <typename Lock>
+ReadAwaiter<Lock> read(BasicConnection<Lock>& conn, void* buf, size_t len) {
+    return ReadAwaiter<Lock>(conn, buf, len);
+}
@@ -0,0 +1 @@
+g++ -shared /root/repo/build/src/.libevloop.so/evloop.o /root/repo/build/src/.libevloop.so/poller.o /root/repo/build/src/.libevloop.so/backend.o /root/repo/build/src/.libevloop.so/uring.o /root/repo/build/src/.libevloop.so/timer.o /root/repo/build/src/.libevloop.so/evloop_group.o /root/repo/build/src/.libevloop.so/loop_stats.o /root/repo/build/src/.libevloop.so/watchdog.o /root/repo/build/src/.libevloop.so/chain_buffer.o /root/repo/build/src/.libevloop.so/connection.o /root/repo/build/src/.libevloop.so/acceptor.o /root/repo/build/src/.libevloop.so/udp_endpoint.o /root/repo/build/src/.libevloop.so/frame_pool.o /root/repo/build/src/.libevloop.so/blocking_pool.o -o /root/repo/build/src/libevloop.so   -L.  -L./  
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cassert>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+
+// Locking policies for the loop classes. ThreadSafe guards every Poller and
+// Timer operation with a shared_mutex. NoLock compiles the locking out for
+// loops that are only used from their own thread; cross-thread access has
+// to go through post(). Debug builds assert on misuse.
+class NullMutex {
+public:
+    void lock() { check_thread(); }
+    void unlock() {}
+    bool try_lock() { check_thread(); return true; }
+    void lock_shared() { check_thread(); }
+    void unlock_shared() {}
+    bool try_lock_shared() { check_thread(); return true; }
+
+#ifndef NDEBUG
+    void bind(std::thread::id owner) { owner_ = owner; }
+
+private:
+    std::thread::id owner_;
+
+    void check_thread() const {
+        assert((owner_ == std::thread::id() || owner_ == std::this_thread::get_id()) &&
+               "loop accessed from a foreign thread, use post()");
+    }
+#else
+    void bind(std::thread::id owner) { (void)owner; }
+
+private:
+    void check_thread() const {}
+#endif
+};
+
+struct ThreadSafe {
+    using mutex_type = std::shared_mutex;
+    static constexpr bool thread_safe = true;
+
+    static void bind(mutex_type& mtx, std::thread::id owner) { (void)mtx; (void)owner; }
+};
+
+struct NoLock {
+    using mutex_type = NullMutex;
+    static constexpr bool thread_safe = false;
+
+    static void bind(mutex_type& mtx, std::thread::id owner) { mtx.bind(owner); }
+};
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <poll.h>
+#include <sys/types.h>
+#include <array>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <queue>
+#include <set>
+#include <list>
+#include <mutex>
+#include <shared_mutex>
+#include <atomic>
+#include <thread>
+#include "backend.h"
+#include "lock_policy.h"
+#include "small_function.h"
+#include "loop_stats.h"
+
+template <typename Lock>
+class BasicPoller {
+public:
+    using FdCallback = SmallFunction<void(int fd, short events, short revents)>;
+    using IoCallback = std::function<void(int fd, int result)>;
+    using TransferCallback = std::function<void(int fd, int64_t result)>;
+
+    explicit BasicPoller(BackendType backend = BackendType::POLL);
+    ~BasicPoller();
+
+    BasicPoller(const BasicPoller&) = delete;
+    BasicPoller& operator=(const BasicPoller&) = delete;
+    BasicPoller(BasicPoller&&) = delete;
+    BasicPoller& operator=(BasicPoller&&) = delete;
+
+    // mode is a combination of PollMode flags. An edge-triggered callback
+    // must read or write until EAGAIN, as readiness it leaves behind is not
+    // reported again; in exchange a socket whose reader is paused does not
+    // wake the loop on every iteration. A oneshot fd is reported once and
+    // then stays quiet until rearm() or update_events().
+    bool add(int fd, short events, FdCallback callback, unsigned mode = POLL_LEVEL);
+
+    bool remove(int fd);
+
+    bool update_events(int fd, short events);
+
+    // Re-arms a POLL_ONESHOT fd with its current events.
+    bool rearm(int fd);
+
+    // Completion style operations. The callback gets the byte count (or the
+    // accepted fd) or -errno. Buffers must stay valid until it fires.
+    bool async_read(int fd, void* buf, size_t len, IoCallback callback);
+
+    bool async_write(int fd, const void* buf, size_t len, IoCallback callback);
+
+    bool async_accept(int fd, IoCallback callback);
+
+    // Zero-copy transfers driven by readiness. The fds must be non-blocking
+    // and not registered yet; they are unregistered again before the
+    // callback gets the byte count or -errno. sendfile and splice have no
+    // MSG_NOSIGNAL, so SIGPIPE should be ignored by the process.
+    //
+    // Sends len bytes of file_fd from offset to the socket fd, or up to the
+    // end of the file when len is 0.
+    bool send_file(int fd, int file_fd, off_t offset, size_t len, TransferCallback callback);
+
+    // Moves everything read from in_fd to out_fd through a kernel pipe until
+    // in_fd reaches EOF. The callback gets in_fd.
+    bool splice_forward(int in_fd, int out_fd, TransferCallback callback);
+
+    int poll(int timeout_ms = -1);
+
+    // Negative waits forever.
+    int poll(std::chrono::nanoseconds timeout);
+
+    void run(int default_timeout_ms = 1000);
+
+    void stop();
+
+    void start();
+
+    bool is_running() const;
+
+    size_t get_fd_count() const;
+
+    void trigger_loop() const;
+
+protected:
+    // Binds the NoLock affinity checks to the calling thread (or releases
+    // them for a default id).
+    void set_owner_thread(std::thread::id owner);
+
+    bool exact_timeouts() const { return backend_->exact_timeouts(); }
+
+    // nullptr disables recording.
+    void set_stats(LoopCounters* stats) { stats_.store(stats, std::memory_order_relaxed); }
+
+private:
+    using Mutex = typename Lock::mutex_type;
+
+    // Handlers live inline in a table indexed by fd. The generation is
+    // bumped on every add so readiness collected for an earlier
+    // registration of the same fd is dropped.
+    struct FdSlot {
+        FdCallback callback;
+        uint32_t gen{0};
+        short events{0};
+        unsigned mode{POLL_LEVEL};
+        bool active{false};
+    };
+
+    static constexpr size_t FD_CHUNK_BITS = 8;
+    static constexpr size_t FD_CHUNK_SIZE = 1 << FD_CHUNK_BITS;
+    static constexpr size_t FD_CHUNK_MASK = FD_CHUNK_SIZE - 1;
+    using FdChunk = std::array<FdSlot, FD_CHUNK_SIZE>;
+
+    struct OpInfo {
+        int fd;
+        IoCallback callback;
+    };
+
+    mutable Mutex mtx;
+    std::unique_ptr<PollerBackend> backend_;
+    std::vector<pollfd> ready_;
+    std::vector<Completion> done_;
+    std::unordered_map<uint64_t, OpInfo> op_map_;
+    uint64_t next_op_token_{1};
+    std::vector<uint32_t> ready_gen_;
+    int wake_fd_{-1};
+    mutable std::atomic<bool> wake_pending_{false};
+    mutable std::atomic<std::thread::id> loop_thread_{};
+    std::atomic<LoopCounters*> stats_{nullptr};
+    // Chunks never move, so growing the table leaves existing slots alone.
+    std::vector<std::unique_ptr<FdChunk>> fd_table_;
+    size_t fd_count_{0};
+    std::atomic<bool> running_{false};
+
+    FdSlot* find_slot(int fd);
+
+    FdSlot& grow_slot(int fd);
+
+    void close_wakeup();
+
+    void handle_wakeup(int fd, short events, short revents);
+
+    bool create_wakeup();
+
+    bool submit_op(AsyncOpType type, int fd, void* buf, size_t len, IoCallback callback);
+
+    struct SpliceState;
+
+    void splice_in(const std::shared_ptr<SpliceState>& state);
+
+    void splice_out(const std::shared_ptr<SpliceState>& state);
+
+    void splice_finish(const std::shared_ptr<SpliceState>& state, int64_t result);
+
+};
+
+using Poller = BasicPoller<ThreadSafe>;
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Move-only replacement for std::function. Callables of up to InlineSize
+// bytes (a lambda capturing a handful of pointers) are stored in place, so
+// arming a handler does not touch the heap. Larger ones fall back to new.
+template <typename Signature, size_t InlineSize = 48>
+class SmallFunction;
+
+template <typename R, typename... Args, size_t InlineSize>
+class SmallFunction<R(Args...), InlineSize> {
+public:
+    SmallFunction() noexcept {}
+
+    SmallFunction(std::nullptr_t) noexcept {}
+
+    template <typename F, typename Fn = std::decay_t<F>,
+              typename = std::enable_if_t<!std::is_same<Fn, SmallFunction>::value &&
+                                          std::is_invocable_r<R, Fn&, Args...>::value>>
+    SmallFunction(F&& f) {
+        if constexpr (std::is_constructible<bool, const Fn&>::value) {
+            if (!f) {
+                return;
+            }
+        }
+        if constexpr (stored_inline<Fn>()) {
+            new (storage_) Fn(std::forward<F>(f));
+        } else {
+            *reinterpret_cast<Fn**>(storage_) = new Fn(std::forward<F>(f));
+        }
+        ops_ = &ops_for<Fn>;
+    }
+
+    SmallFunction(SmallFunction&& other) noexcept {
+        take(other);
+    }
+
+    SmallFunction& operator=(SmallFunction&& other) noexcept {
+        if (this != &other) {
+            reset();
+            take(other);
+        }
+        return *this;
+    }
+
+    SmallFunction& operator=(std::nullptr_t) noexcept {
+        reset();
+        return *this;
+    }
+
+    SmallFunction(const SmallFunction&) = delete;
+    SmallFunction& operator=(const SmallFunction&) = delete;
+
+    ~SmallFunction() {
+        reset();
+    }
+
+    explicit operator bool() const noexcept {
+        return ops_ != nullptr;
+    }
+
+    R operator()(Args... args) const {
+        return ops_->invoke(storage_, std::forward<Args>(args)...);
+    }
+
+private:
+    struct Ops {
+        R (*invoke)(void* storage, Args&&... args);
+        // Moves the callable from src to dst and destroys the source.
+        void (*relocate)(void* dst, void* src) noexcept;
+        void (*destroy)(void* storage) noexcept;
+    };
+
+    template <typename Fn>
+    static constexpr bool stored_inline() {
+        return sizeof(Fn) <= InlineSize && alignof(Fn) <= alignof(std::max_align_t) &&
+            std::is_nothrow_move_constructible<Fn>::value;
+    }
+
+    template <typename Fn>
+    static Fn* target(void* storage) {
+        if constexpr (stored_inline<Fn>()) {
+            return std::launder(reinterpret_cast<Fn*>(storage));
+        } else {
+            return *reinterpret_cast<Fn**>(storage);
+        }
+    }
+
+    template <typename Fn>
+    static R invoke(void* storage, Args&&... args) {
+        return (*target<Fn>(storage))(std::forward<Args>(args)...);
+    }
+
+    template <typename Fn>
+    static void relocate(void* dst, void* src) noexcept {
+        if constexpr (stored_inline<Fn>()) {
+            Fn* fn = target<Fn>(src);
+            new (dst) Fn(std::move(*fn));
+            fn->~Fn();
+        } else {
+            *reinterpret_cast<Fn**>(dst) = *reinterpret_cast<Fn**>(src);
+        }
+    }
+
+    template <typename Fn>
+    static void destroy(void* storage) noexcept {
+        if constexpr (stored_inline<Fn>()) {
+            target<Fn>(storage)->~Fn();
+        } else {
+            delete target<Fn>(storage);
+        }
+    }
+
+    template <typename Fn>
+    static constexpr Ops ops_for = {&invoke<Fn>, &relocate<Fn>, &destroy<Fn>};
+
+    void take(SmallFunction& other) noexcept {
+        if (other.ops_) {
+            other.ops_->relocate(storage_, other.storage_);
+            ops_ = other.ops_;
+            other.ops_ = nullptr;
+        }
+    }
+
+    void reset() noexcept {
+        if (ops_) {
+            ops_->destroy(storage_);
+            ops_ = nullptr;
+        }
+    }
+
+    alignas(std::max_align_t) mutable unsigned char storage_[InlineSize];
+    const Ops* ops_{nullptr};
+};
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <poll.h>
+#include <array>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <queue>
+#include <set>
+#include <list>
+#include <mutex>
+#include <shared_mutex>
+#include "lock_policy.h"
+#include "small_function.h"
+#include "loop_stats.h"
+
+// QUEUE timers are kept in a heap and fire precisely. WHEEL timers go into
+// a hierarchical timing wheel with O(1) arm/cancel and fire on tick
+// granularity, which suits large numbers of coarse timeouts.
+enum class TimerMode {
+    QUEUE,
+    WHEEL,
+};
+
+template <typename Lock>
+class BasicTimer {
+public:
+    using TimerCallback = SmallFunction<void(int timer_id)>;
+    using TimePoint = std::chrono::steady_clock::time_point;
+
+    BasicTimer();
+    ~BasicTimer() {};
+    BasicTimer(const BasicTimer&) = delete;
+    BasicTimer& operator=(const BasicTimer&) = delete;
+    BasicTimer(BasicTimer&&) = delete;
+    BasicTimer& operator=(BasicTimer&&) = delete;
+
+    int add_timer(int interval_ms, TimerCallback callback, bool repeat = true,
+                  TimerMode mode = TimerMode::QUEUE);
+    // QUEUE timers keep the full resolution; WHEEL timers round up to ticks.
+    int add_timer(std::chrono::nanoseconds interval, TimerCallback callback, bool repeat = true,
+                  TimerMode mode = TimerMode::QUEUE);
+    // The timer may fire up to slack after each deadline, so that timers
+    // with overlapping windows share one wakeup.
+    int add_timer(std::chrono::nanoseconds interval, std::chrono::nanoseconds slack,
+                  TimerCallback callback, bool repeat = true, TimerMode mode = TimerMode::QUEUE);
+    bool remove_timer(int timer_id);
+    bool update_timer_interval(int timer_id, int interval_ms);
+    bool update_timer_interval(int timer_id, std::chrono::nanoseconds interval);
+    size_t get_timer_count() const;
+    // Timer wakeups avoided by firing slack timers together.
+    uint64_t get_wakeups_saved() const;
+
+    // Only allowed while no wheel timer is armed. Each level has 256 slots.
+    bool configure_wheel(int tick_ms, int levels);
+private:
+    using Mutex = typename Lock::mutex_type;
+
+    static constexpr size_t NOT_QUEUED = static_cast<size_t>(-1);
+
+    // Slab entry. A firing timer has its callback moved out while it runs
+    // and is only returned to the free list once the callback is done.
+    struct TimerInfo {
+        int id{0};
+        TimerCallback callback;
+        TimePoint next_fire;
+        // next_fire pushed back within the slack; what the queues order by.
+        TimePoint deadline;
+        std::chrono::nanoseconds interval{0};
+        std::chrono::nanoseconds slack{0};
+        bool repeat{false};
+        bool active{false};
+        bool firing{false};
+        TimerMode mode{TimerMode::QUEUE};
+        size_t heap_index{NOT_QUEUED};
+        size_t wheel_slot{NOT_QUEUED};
+        uint64_t expire_tick{0};
+        TimerInfo* wheel_prev{nullptr};
+        TimerInfo* wheel_next{nullptr};
+    };
+    static constexpr int WHEEL_BITS = 8;
+    static constexpr size_t WHEEL_SLOTS = size_t(1) << WHEEL_BITS;
+    static constexpr uint64_t WHEEL_MASK = WHEEL_SLOTS - 1;
+    static constexpr int WHEEL_MAX_LEVELS = 7;
+    static constexpr size_t TIMER_CHUNK_BITS = 8;
+    static constexpr size_t TIMER_CHUNK_SIZE = size_t(1) << TIMER_CHUNK_BITS;
+    static constexpr size_t TIMER_CHUNK_MASK = TIMER_CHUNK_SIZE - 1;
+    using TimerChunk = std::array<TimerInfo, TIMER_CHUNK_SIZE>;
+
+    // A timer id holds slab index + 1 in its low bits and the slot's
+    // generation above, bumped on every reuse.
+    static constexpr int TIMER_INDEX_BITS = 21;
+    static constexpr uint32_t TIMER_INDEX_MASK = (uint32_t(1) << TIMER_INDEX_BITS) - 1;
+    static constexpr uint32_t TIMER_GEN_MASK = (uint32_t(1) << (31 - TIMER_INDEX_BITS)) - 1;
+
+    mutable Mutex mtx;
+    // Freed slots are reused before the slab grows.
+    std::vector<std::unique_ptr<TimerChunk>> timer_slab_;
+    std::vector<uint32_t> free_slots_;
+    size_t timer_count_;
+    uint64_t wakeups_saved_;
+    TimePoint last_process_;
+    std::vector<TimerInfo*> timer_heap_;
+
+    std::chrono::nanoseconds wheel_tick_;
+    int wheel_levels_;
+    TimePoint wheel_epoch_;
+    uint64_t wheel_base_;
+    size_t wheel_count_;
+    std::vector<TimerInfo*> wheel_slots_;
+    std::vector<uint64_t> wheel_bitmap_;
+    std::vector<TimerInfo*> expired_;
+    std::atomic<LoopCounters*> stats_{nullptr};
+
+    void heap_push(TimerInfo* timer);
+    void heap_erase(TimerInfo* timer);
+    void heap_update(TimerInfo* timer);
+    void heap_sift_up(size_t index);
+    void heap_sift_down(size_t index);
+    void heap_set(size_t index, TimerInfo* timer);
+    void wheel_add(TimerInfo* timer);
+    void wheel_insert(TimerInfo* timer);
+    void wheel_remove(TimerInfo* timer);
+    void wheel_cascade(int level, size_t index);
+    void wheel_cascade_boundary();
+    void wheel_advance(TimePoint now);
+    int wheel_find_slot(size_t from) const;
+    bool wheel_next_deadline(TimePoint& deadline) const;
+    void schedule(TimerInfo* timer);
+    void unschedule(TimerInfo* timer);
+    void fire_timer(TimerInfo* timer, std::unique_lock<Mutex>& lock, TimePoint now);
+    void release_timer(TimerInfo* timer);
+    void set_next_fire(TimerInfo* timer, TimePoint next_fire);
+    void count_fired(const TimerInfo* timer, size_t& exact, size_t& slacked) const;
+    TimerInfo* alloc_timer();
+    void free_timer(TimerInfo* timer);
+    TimerInfo* find_timer(int timer_id);
+    void timer_qinfo();
+protected:
+    void set_owner_thread(std::thread::id owner);
+    // nullptr disables recording.
+    void set_stats(LoopCounters* stats) { stats_.store(stats, std::memory_order_relaxed); }
+    void process_timers();
+    // TimePoint::max() when nothing is armed.
+    TimePoint next_deadline() const;
+    // Time until the next deadline, capped at default_timeout unless that
+    // is negative.
+    std::chrono::nanoseconds calculate_timeout(std::chrono::nanoseconds default_timeout) const;
+};
+
+using Timer = BasicTimer<ThreadSafe>;
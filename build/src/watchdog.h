@@ -0,0 +1,61 @@
+#pragma once
+
+#include <pthread.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "loop_stats.h"
+
+struct StallReport {
+    // How long the iteration had been running when it was noticed.
+    std::chrono::nanoseconds stalled;
+    // The callback running at that moment, -1 when none.
+    int fd;
+    int timer_id;
+    // Symbolized frames of the loop thread, empty unless requested.
+    std::vector<std::string> backtrace;
+};
+
+// Watches the busy/current state a loop publishes through LoopCounters and
+// reports iterations that run longer than the threshold. Each stalled
+// iteration is reported once, from the watchdog thread.
+class LoopWatchdog {
+public:
+    using StallCallback = std::function<void(const StallReport& report)>;
+
+    // backtrace_signal 0 disables backtraces. Otherwise its handler is
+    // replaced process wide.
+    LoopWatchdog(const LoopCounters& counters, std::chrono::milliseconds threshold,
+                 StallCallback hook, int backtrace_signal = 0);
+    ~LoopWatchdog();
+
+    LoopWatchdog(const LoopWatchdog&) = delete;
+    LoopWatchdog& operator=(const LoopWatchdog&) = delete;
+
+    // Sets the thread that gets the backtrace signal.
+    void attach(pthread_t loop_thread);
+
+    void detach();
+
+private:
+    const LoopCounters& counters_;
+    std::chrono::milliseconds threshold_;
+    StallCallback hook_;
+    int backtrace_signal_;
+    std::atomic<bool> attached_{false};
+    pthread_t loop_thread_{};
+    std::mutex mtx;
+    std::condition_variable cv_;
+    bool stop_{false};
+    uint64_t reported_since_{0};
+    std::thread thread_;
+
+    void watch();
+
+    std::vector<std::string> capture_backtrace();
+};
@@ -0,0 +1 @@
+g++ -Wall -Wextra -Werror -pipe -g3 -O2 -fsigned-char -fno-strict-aliasing -fPIC -Werror=unused-result   -I. -I../src/  -c blocking_pool_test.cpp -o /root/repo/build/tests/.blocking_pool_test/blocking_pool_test.o
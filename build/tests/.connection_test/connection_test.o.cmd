@@ -0,0 +1 @@
+g++ -Wall -Wextra -Werror -pipe -g3 -O2 -fsigned-char -fno-strict-aliasing -fPIC -Werror=unused-result   -I. -I../src/ -std=c++20  -c connection_test.cpp -o /root/repo/build/tests/.connection_test/connection_test.o
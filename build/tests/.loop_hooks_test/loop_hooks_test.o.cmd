@@ -0,0 +1 @@
+g++ -Wall -Wextra -Werror -pipe -g3 -O2 -fsigned-char -fno-strict-aliasing -fPIC -Werror=unused-result   -I. -I../src/  -c loop_hooks_test.cpp -o /root/repo/build/tests/.loop_hooks_test/loop_hooks_test.o
@@ -0,0 +1 @@
+g++ -Wall -Wextra -Werror -pipe -g3 -O2 -fsigned-char -fno-strict-aliasing -fPIC -Werror=unused-result   -I. -I../src/  -c poll_mode_test.cpp -o /root/repo/build/tests/.poll_mode_test/poll_mode_test.o
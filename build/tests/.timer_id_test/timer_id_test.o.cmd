@@ -0,0 +1 @@
+g++ -Wall -Wextra -Werror -pipe -g3 -O2 -fsigned-char -fno-strict-aliasing -fPIC -Werror=unused-result   -I. -I../src/  -c timer_id_test.cpp -o /root/repo/build/tests/.timer_id_test/timer_id_test.o
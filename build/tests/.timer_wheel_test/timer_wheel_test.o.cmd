@@ -0,0 +1 @@
+g++ -Wall -Wextra -Werror -pipe -g3 -O2 -fsigned-char -fno-strict-aliasing -fPIC -Werror=unused-result   -I. -I../src/  -c timer_wheel_test.cpp -o /root/repo/build/tests/.timer_wheel_test/timer_wheel_test.o
@@ -0,0 +1 @@
+g++ /root/repo/build/tests/.blocking_pool_test/blocking_pool_test.o /root/repo/build/tests/.blocking_pool_test/../src/evloop.o /root/repo/build/tests/.blocking_pool_test/../src/timer.o /root/repo/build/tests/.blocking_pool_test/../src/poller.o /root/repo/build/tests/.blocking_pool_test/../src/backend.o /root/repo/build/tests/.blocking_pool_test/../src/uring.o /root/repo/build/tests/.blocking_pool_test/../src/loop_stats.o /root/repo/build/tests/.blocking_pool_test/../src/watchdog.o /root/repo/build/tests/.blocking_pool_test/../src/frame_pool.o /root/repo/build/tests/.blocking_pool_test/../src/chain_buffer.o /root/repo/build/tests/.blocking_pool_test/../src/connection.o /root/repo/build/tests/.blocking_pool_test/../src/blocking_pool.o -o /root/repo/build/tests/blocking_pool_test   -L.  -L./  
@@ -0,0 +1 @@
+g++ /root/repo/build/tests/.loop_hooks_test/loop_hooks_test.o /root/repo/build/tests/.loop_hooks_test/../src/evloop.o /root/repo/build/tests/.loop_hooks_test/../src/timer.o /root/repo/build/tests/.loop_hooks_test/../src/poller.o /root/repo/build/tests/.loop_hooks_test/../src/backend.o /root/repo/build/tests/.loop_hooks_test/../src/uring.o /root/repo/build/tests/.loop_hooks_test/../src/loop_stats.o /root/repo/build/tests/.loop_hooks_test/../src/watchdog.o /root/repo/build/tests/.loop_hooks_test/../src/frame_pool.o /root/repo/build/tests/.loop_hooks_test/../src/chain_buffer.o /root/repo/build/tests/.loop_hooks_test/../src/connection.o /root/repo/build/tests/.loop_hooks_test/../src/blocking_pool.o -o /root/repo/build/tests/loop_hooks_test   -L.  -L./  
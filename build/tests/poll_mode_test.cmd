@@ -0,0 +1 @@
+g++ /root/repo/build/tests/.poll_mode_test/poll_mode_test.o /root/repo/build/tests/.poll_mode_test/../src/poller.o /root/repo/build/tests/.poll_mode_test/../src/backend.o /root/repo/build/tests/.poll_mode_test/../src/uring.o /root/repo/build/tests/.poll_mode_test/../src/loop_stats.o -o /root/repo/build/tests/poll_mode_test   -L.  -L./  
@@ -0,0 +1 @@
+g++ /root/repo/build/tests/.timer_id_test/timer_id_test.o /root/repo/build/tests/.timer_id_test/../src/evloop.o /root/repo/build/tests/.timer_id_test/../src/timer.o /root/repo/build/tests/.timer_id_test/../src/poller.o /root/repo/build/tests/.timer_id_test/../src/backend.o /root/repo/build/tests/.timer_id_test/../src/uring.o /root/repo/build/tests/.timer_id_test/../src/loop_stats.o /root/repo/build/tests/.timer_id_test/../src/watchdog.o /root/repo/build/tests/.timer_id_test/../src/frame_pool.o /root/repo/build/tests/.timer_id_test/../src/chain_buffer.o /root/repo/build/tests/.timer_id_test/../src/connection.o /root/repo/build/tests/.timer_id_test/../src/blocking_pool.o -o /root/repo/build/tests/timer_id_test   -L.  -L./  
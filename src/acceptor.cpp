@@ -0,0 +1,150 @@
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include "acceptor.h"
+//#define DEBUG
+
+#ifdef DEBUG
+#define dbg(a...) do { \
+    std::cerr << "[DEBUG] " << __FILE__ << ":" << __LINE__ << ":" << __FUNCTION__ <<" "; \
+    fprintf(stderr, a); \
+    std::cerr << std::endl; \
+} while(0)
+#else
+#define dbg(fmt, ...) do { } while(0)
+#endif
+
+static int create_listener(int port, int backlog, bool reuseport) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        perror("socket");
+        return -1;
+    }
+
+    int opt = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    if (reuseport && setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) < 0) {
+        perror("setsockopt(SO_REUSEPORT)");
+        ::close(fd);
+        return -1;
+    }
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = INADDR_ANY;
+    addr.sin_port = htons(port);
+
+    if (bind(fd, (sockaddr*)&addr, sizeof(addr)) < 0) {
+        perror("bind");
+        ::close(fd);
+        return -1;
+    }
+
+    if (::listen(fd, backlog) < 0) {
+        perror("listen");
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+template <typename Lock>
+BasicAcceptor<Lock>::BasicAcceptor(BasicPoller<Lock>& poller) : poller_(poller) {
+}
+
+template <typename Lock>
+BasicAcceptor<Lock>::~BasicAcceptor() {
+    close();
+}
+
+template <typename Lock>
+bool BasicAcceptor<Lock>::listen(int port, AcceptCallback callback, int backlog, bool reuseport) {
+    if (fd_ >= 0 || !callback) {
+        return false;
+    }
+
+    fd_ = create_listener(port, backlog, reuseport);
+    if (fd_ < 0) {
+        return false;
+    }
+    sockaddr_in addr{};
+    socklen_t len = sizeof(addr);
+    if (getsockname(fd_, (sockaddr*)&addr, &len) == 0) {
+        port_ = ntohs(addr.sin_port);
+    }
+    reserve_fd_ = open("/dev/null", O_RDONLY | O_CLOEXEC);
+    if (reserve_fd_ < 0) {
+        dbg("Failed to open reserve fd: %s", strerror(errno));
+    }
+
+    callback_ = std::move(callback);
+    auto handler = [this](int fd, short events, short revents) {
+        (void)fd;
+        (void)events;
+        if (revents & POLLIN) {
+            handle_accept();
+        }
+    };
+    if (!poller_.add(fd_, POLLIN, handler)) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+template <typename Lock>
+void BasicAcceptor<Lock>::close() {
+    if (fd_ >= 0) {
+        poller_.remove(fd_);
+        ::close(fd_);
+        fd_ = -1;
+    }
+    if (reserve_fd_ >= 0) {
+        ::close(reserve_fd_);
+        reserve_fd_ = -1;
+    }
+}
+
+template <typename Lock>
+void BasicAcceptor<Lock>::handle_accept() {
+    for (size_t i = 0; i < budget_ && fd_ >= 0; i++) {
+        int cfd = accept4(fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (cfd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            if (errno == EMFILE || errno == ENFILE) {
+                drop_pending();
+            } else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                std::cerr << "accept failed: " << strerror(errno) << std::endl;
+            }
+            return;
+        }
+        accepted_++;
+        callback_(cfd);
+    }
+}
+
+// Out of fds: the pending connection is accepted on the reserved slot and
+// closed at once, which tells the client instead of leaving it queued.
+template <typename Lock>
+void BasicAcceptor<Lock>::drop_pending() {
+    if (reserve_fd_ < 0) {
+        std::cerr << "accept failed: " << strerror(EMFILE) << ", no reserve fd" << std::endl;
+        return;
+    }
+    ::close(reserve_fd_);
+    int cfd = accept4(fd_, nullptr, nullptr, SOCK_CLOEXEC);
+    if (cfd >= 0) {
+        ::close(cfd);
+        dropped_++;
+    }
+    reserve_fd_ = open("/dev/null", O_RDONLY | O_CLOEXEC);
+    dbg("dropped a connection, out of fds");
+}
+
+template class BasicAcceptor<ThreadSafe>;
+template class BasicAcceptor<NoLock>;
@@ -0,0 +1,241 @@
+#include <iostream>
+#include <algorithm>
+#include <unistd.h>
+#include <cstring>
+#include <cerrno>
+#include <climits>
+#include "backend.h"
+//#define DEBUG
+
+#ifdef DEBUG
+#define dbg(a...) do { \
+    std::cerr << "[DEBUG] " << __FILE__ << ":" << __LINE__ << ":" << __FUNCTION__ <<" "; \
+    fprintf(stderr, a); \
+    std::cerr << std::endl; \
+} while(0)
+#else
+#define dbg(fmt, ...) do { } while(0)
+#endif
+
+timespec PollerBackend::to_timespec(std::chrono::nanoseconds timeout) {
+    timespec ts;
+    ts.tv_sec = timeout.count() / 1000000000L;
+    ts.tv_nsec = timeout.count() % 1000000000L;
+    return ts;
+}
+
+std::unique_ptr<PollerBackend> PollerBackend::create(BackendType type) {
+    if (type == BackendType::URING) {
+        auto backend = std::make_unique<UringBackend>();
+        if (backend->valid()) {
+            return backend;
+        }
+        std::cerr << "Failed to create io_uring backend, falling back to epoll" << std::endl;
+        type = BackendType::EPOLL;
+    }
+    if (type == BackendType::EPOLL) {
+        auto backend = std::make_unique<EpollBackend>();
+        if (backend->valid()) {
+            return backend;
+        }
+        std::cerr << "Failed to create epoll backend, falling back to poll" << std::endl;
+    }
+    return std::make_unique<PollBackend>();
+}
+
+// poll() has no edge notification, so POLL_EDGE fds are reported like
+// level-triggered ones. That is a superset of the edge reports, and a
+// callback that drains the fd gets EAGAIN on the extra ones.
+bool PollBackend::add(int fd, short events, unsigned mode) {
+    if (fd < 0) {
+        return false;
+    }
+    if (static_cast<size_t>(fd) >= index_.size()) {
+        index_.resize(fd + 1, -1);
+        oneshot_.resize(fd + 1, ONESHOT_NONE);
+    }
+    if (index_[fd] >= 0) {
+        return false;
+    }
+    index_[fd] = fds_.size();
+    fds_.push_back({
+        .fd = fd,
+        .events = events,
+        .revents = 0
+    });
+    if (mode & POLL_ONESHOT) {
+        oneshot_[fd] = ONESHOT_PENDING;
+        oneshot_count_++;
+    }
+    return true;
+}
+
+bool PollBackend::modify(int fd, short events, unsigned mode) {
+    if (fd < 0 || static_cast<size_t>(fd) >= index_.size() || index_[fd] < 0) {
+        return false;
+    }
+    fds_[index_[fd]].events = events;
+    if (oneshot_[fd] != ONESHOT_NONE) {
+        oneshot_count_--;
+    }
+    oneshot_[fd] = ONESHOT_NONE;
+    if (mode & POLL_ONESHOT) {
+        oneshot_[fd] = ONESHOT_PENDING;
+        oneshot_count_++;
+    }
+    return true;
+}
+
+bool PollBackend::remove(int fd) {
+    if (fd < 0 || static_cast<size_t>(fd) >= index_.size() || index_[fd] < 0) {
+        return false;
+    }
+    if (oneshot_[fd] != ONESHOT_NONE) {
+        oneshot_[fd] = ONESHOT_NONE;
+        oneshot_count_--;
+    }
+    size_t pos = index_[fd];
+    index_[fd] = -1;
+    if (pos != fds_.size() - 1) {
+        fds_[pos] = fds_.back();
+        index_[fds_[pos].fd] = pos;
+    }
+    fds_.pop_back();
+    return true;
+}
+
+void PollBackend::prepare() {
+    if (oneshot_count_ == 0) {
+        poll_set_ = fds_;
+        return;
+    }
+    poll_set_.clear();
+    for (const auto& pfd : fds_) {
+        unsigned char& state = oneshot_[pfd.fd];
+        if (state == ONESHOT_DISARMED) {
+            continue;
+        }
+        if (state == ONESHOT_PENDING) {
+            state = ONESHOT_ARMED;
+        }
+        poll_set_.push_back(pfd);
+    }
+}
+
+int PollBackend::wait(std::chrono::nanoseconds timeout) {
+    if (poll_set_.empty()) {
+        return -1;
+    }
+    timespec ts = to_timespec(timeout);
+    return ::ppoll(poll_set_.data(), poll_set_.size(), timeout.count() < 0 ? nullptr : &ts, nullptr);
+}
+
+void PollBackend::collect(std::vector<pollfd>& ready, std::vector<Completion>& done) {
+    ready.clear();
+    done.clear();
+    for (const auto& pfd : poll_set_) {
+        if (pfd.revents == 0) {
+            continue;
+        }
+        ready.push_back(pfd);
+        if (oneshot_[pfd.fd] == ONESHOT_ARMED) {
+            oneshot_[pfd.fd] = ONESHOT_DISARMED;
+        }
+    }
+}
+
+EpollBackend::EpollBackend(): pwait2_(true), fd_count_(0), nevents_(0), events_(64) {
+    epfd_ = epoll_create1(EPOLL_CLOEXEC);
+    if (epfd_ < 0) {
+        dbg("Failed to create epoll fd: %s", strerror(errno));
+    }
+}
+
+EpollBackend::~EpollBackend() {
+    if (epfd_ >= 0) {
+        close(epfd_);
+    }
+}
+
+static uint32_t epoll_events(short events, unsigned mode) {
+    uint32_t result = static_cast<unsigned short>(events);
+    if (mode & POLL_EDGE) {
+        result |= EPOLLET;
+    }
+    if (mode & POLL_ONESHOT) {
+        result |= EPOLLONESHOT;
+    }
+    return result;
+}
+
+bool EpollBackend::add(int fd, short events, unsigned mode) {
+    epoll_event ev{};
+    ev.events = epoll_events(events, mode);
+    ev.data.fd = fd;
+    if (epoll_ctl(epfd_, EPOLL_CTL_ADD, fd, &ev) < 0) {
+        dbg("epoll add fd %d failed: %s", fd, strerror(errno));
+        return false;
+    }
+    fd_count_++;
+    return true;
+}
+
+bool EpollBackend::modify(int fd, short events, unsigned mode) {
+    epoll_event ev{};
+    ev.events = epoll_events(events, mode);
+    ev.data.fd = fd;
+    if (epoll_ctl(epfd_, EPOLL_CTL_MOD, fd, &ev) < 0) {
+        dbg("epoll mod fd %d failed: %s", fd, strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+bool EpollBackend::remove(int fd) {
+    if (epoll_ctl(epfd_, EPOLL_CTL_DEL, fd, nullptr) < 0) {
+        dbg("epoll del fd %d failed: %s", fd, strerror(errno));
+        return false;
+    }
+    fd_count_--;
+    return true;
+}
+
+void EpollBackend::prepare() {
+    if (events_.size() < std::min(fd_count_, size_t(4096))) {
+        events_.resize(events_.size() * 2);
+    }
+}
+
+// epoll_pwait2 takes a timespec; kernels before 5.11 only have the
+// millisecond epoll_wait, so round up there.
+int EpollBackend::wait(std::chrono::nanoseconds timeout) {
+    if (pwait2_) {
+        timespec ts = to_timespec(timeout);
+        nevents_ = epoll_pwait2(epfd_, events_.data(), events_.size(),
+                                timeout.count() < 0 ? nullptr : &ts, nullptr);
+        if (nevents_ >= 0 || errno != ENOSYS) {
+            return nevents_;
+        }
+        pwait2_ = false;
+    }
+    int timeout_ms = -1;
+    if (timeout.count() >= 0) {
+        timeout_ms = static_cast<int>(std::min<int64_t>(
+            std::chrono::ceil<std::chrono::milliseconds>(timeout).count(), INT_MAX));
+    }
+    nevents_ = epoll_wait(epfd_, events_.data(), events_.size(), timeout_ms);
+    return nevents_;
+}
+
+void EpollBackend::collect(std::vector<pollfd>& ready, std::vector<Completion>& done) {
+    ready.clear();
+    done.clear();
+    for (int i = 0; i < nevents_; i++) {
+        ready.push_back({
+            .fd = events_[i].data.fd,
+            .events = 0,
+            .revents = static_cast<short>(events_[i].events)
+        });
+    }
+    nevents_ = 0;
+}
@@ -0,0 +1,191 @@
+#pragma once
+
+#include <poll.h>
+#include <sys/epoll.h>
+#include <time.h>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+
+enum class BackendType {
+    POLL,
+    EPOLL,
+    URING,
+};
+
+// How a registered fd is reported. Level-triggered fds are reported on
+// every wait while they are ready. POLL_EDGE reports an fd when it becomes
+// ready, so the callback must read or write until EAGAIN or it may not be
+// reported again. POLL_ONESHOT disarms the fd after one report until it is
+// modified again. The two can be combined.
+enum PollMode : unsigned {
+    POLL_LEVEL = 0,
+    POLL_EDGE = 1 << 0,
+    POLL_ONESHOT = 1 << 1,
+};
+
+enum class AsyncOpType {
+    READ,
+    WRITE,
+    ACCEPT,
+};
+
+struct AsyncOp {
+    AsyncOpType type;
+    int fd;
+    void* buf;
+    size_t len;
+    uint64_t token;
+};
+
+struct Completion {
+    uint64_t token;
+    int res;
+};
+
+class PollerBackend {
+public:
+    virtual ~PollerBackend() {}
+
+    virtual bool add(int fd, short events, unsigned mode) = 0;
+
+    // Also re-arms a disarmed POLL_ONESHOT fd.
+    virtual bool modify(int fd, short events, unsigned mode) = 0;
+
+    virtual bool remove(int fd) = 0;
+
+    // Completion based backends queue the operation and report it through
+    // collect(). Readiness based backends return false.
+    virtual bool submit(const AsyncOp& op) { (void)op; return false; }
+
+    // Called with the poller lock held, right before wait().
+    virtual void prepare() {}
+
+    // Blocks without the poller lock for at most timeout, forever when it is
+    // negative. Returns the number of events or -1.
+    virtual int wait(std::chrono::nanoseconds timeout) = 0;
+
+    // Called with the poller lock held after wait() returned.
+    virtual void collect(std::vector<pollfd>& ready, std::vector<Completion>& done) = 0;
+
+    // False when wait() timeouts are stretched by the thread's timer slack
+    // (50us by default for poll and epoll).
+    virtual bool exact_timeouts() const { return false; }
+
+    static std::unique_ptr<PollerBackend> create(BackendType type);
+
+protected:
+    static timespec to_timespec(std::chrono::nanoseconds timeout);
+};
+
+class PollBackend: public PollerBackend {
+public:
+    bool add(int fd, short events, unsigned mode) override;
+    bool modify(int fd, short events, unsigned mode) override;
+    bool remove(int fd) override;
+    void prepare() override;
+    int wait(std::chrono::nanoseconds timeout) override;
+    void collect(std::vector<pollfd>& ready, std::vector<Completion>& done) override;
+
+private:
+    // A oneshot fd is armed once prepare() puts it in the poll set, so a
+    // report for an earlier registration does not disarm a new one.
+    enum : unsigned char {
+        ONESHOT_NONE,
+        ONESHOT_PENDING,
+        ONESHOT_ARMED,
+        ONESHOT_DISARMED,
+    };
+
+    std::vector<pollfd> fds_;
+    // Position in fds_ by fd, -1 when not registered.
+    std::vector<int> index_;
+    // By fd.
+    std::vector<unsigned char> oneshot_;
+    size_t oneshot_count_{0};
+    std::vector<pollfd> poll_set_;
+};
+
+class EpollBackend: public PollerBackend {
+public:
+    EpollBackend();
+    ~EpollBackend();
+
+    bool valid() const { return epfd_ >= 0; }
+
+    bool add(int fd, short events, unsigned mode) override;
+    bool modify(int fd, short events, unsigned mode) override;
+    bool remove(int fd) override;
+    void prepare() override;
+    int wait(std::chrono::nanoseconds timeout) override;
+    void collect(std::vector<pollfd>& ready, std::vector<Completion>& done) override;
+
+private:
+    int epfd_;
+    bool pwait2_;
+    size_t fd_count_;
+    int nevents_;
+    std::vector<epoll_event> events_;
+};
+
+class UringBackend: public PollerBackend {
+public:
+    explicit UringBackend(unsigned entries = 256);
+    ~UringBackend();
+
+    bool valid() const { return ring_fd_ >= 0; }
+
+    bool add(int fd, short events, unsigned mode) override;
+    bool modify(int fd, short events, unsigned mode) override;
+    bool remove(int fd) override;
+    bool submit(const AsyncOp& op) override;
+    void prepare() override;
+    int wait(std::chrono::nanoseconds timeout) override;
+    void collect(std::vector<pollfd>& ready, std::vector<Completion>& done) override;
+    bool exact_timeouts() const override { return true; }
+
+private:
+    struct PollReg {
+        short events;
+        unsigned mode;
+        uint32_t seq;
+        // Multishot completions of one collect() are merged into one entry.
+        uint32_t collected;
+        size_t ready_index;
+        bool armed;
+        bool registered;
+    };
+
+    int ring_fd_;
+    void* sq_ptr_;
+    size_t sq_size_;
+    void* cq_ptr_;
+    size_t cq_size_;
+    struct io_uring_sqe* sqes_;
+    size_t sqes_size_;
+    unsigned sq_entries_;
+    unsigned* sq_head_;
+    unsigned* sq_tail_;
+    unsigned* sq_mask_;
+    unsigned* sq_array_;
+    unsigned* cq_head_;
+    unsigned* cq_tail_;
+    unsigned* cq_mask_;
+    struct io_uring_cqe* cqes_;
+
+    uint32_t next_seq_;
+    uint32_t collect_count_{0};
+    // Indexed by fd.
+    std::vector<PollReg> regs_;
+    std::vector<int> rearm_;
+
+    PollReg* find_reg(int fd);
+    struct io_uring_sqe* get_sqe();
+    bool queue_poll(int fd, const PollReg& reg);
+    void queue_poll_remove(int fd, const PollReg& reg);
+    int enter(unsigned to_submit, unsigned min_complete, unsigned flags,
+              std::chrono::nanoseconds timeout);
+    void unmap();
+};
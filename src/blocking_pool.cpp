@@ -0,0 +1,174 @@
+#include <iostream>
+#include <algorithm>
+#include <sstream>
+#include <signal.h>
+#include "blocking_pool.h"
+#include "loop_stats.h"
+//#define DEBUG
+
+#ifdef DEBUG
+#define dbg(a...) do { \
+    std::cerr << "[DEBUG] " << __FILE__ << ":" << __LINE__ << ":" << __FUNCTION__ <<" "; \
+    fprintf(stderr, a); \
+    std::cerr << std::endl; \
+} while(0)
+#else
+#define dbg(fmt, ...) do { } while(0)
+#endif
+
+std::string BlockingPoolStats::to_json() const {
+    std::ostringstream out;
+    out << "{\"threads\":" << threads
+        << ",\"depth\":" << depth
+        << ",\"max_depth\":" << max_depth
+        << ",\"submitted\":" << submitted
+        << ",\"completed\":" << completed
+        << ",\"stolen\":" << stolen
+        << ",\"queue_wait_us\":";
+    write_histogram(out, queue_wait_us, LATENCY_BUCKETS);
+    out << ",\"run_us\":";
+    write_histogram(out, run_us, LATENCY_BUCKETS);
+    out << ",\"completion_us\":";
+    write_histogram(out, completion_us, LATENCY_BUCKETS);
+    out << "}";
+    return out.str();
+}
+
+BlockingPool::BlockingPool(size_t threads) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (size_t i = 0; i < threads; i++) {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+    for (size_t i = 0; i < threads; i++) {
+        workers_[i]->thread = std::thread([this, i]() { run_worker(i); });
+    }
+}
+
+BlockingPool::~BlockingPool() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stop_.store(true);
+    }
+    cv_.notify_all();
+    for (auto& worker : workers_) {
+        worker->thread.join();
+    }
+}
+
+BlockingPool& BlockingPool::shared() {
+    static BlockingPool pool(std::max(2u, std::thread::hardware_concurrency()));
+    return pool;
+}
+
+bool BlockingPool::submit(Job job) {
+    if (!job || stop_.load()) {
+        return false;
+    }
+    Worker& worker = *workers_[next_.fetch_add(1, std::memory_order_relaxed) % workers_.size()];
+    submitted_.fetch_add(1, std::memory_order_relaxed);
+    uint64_t depth;
+    {
+        // Counted under the queue lock, which take() holds to uncount it, so
+        // depth_ never runs ahead of the queues nor below zero.
+        std::lock_guard<std::mutex> lock(worker.mtx);
+        worker.queue.push_back({std::move(job), Clock::now()});
+        depth = depth_.fetch_add(1) + 1;
+    }
+    uint64_t max_depth = max_depth_.load(std::memory_order_relaxed);
+    while (depth > max_depth && !max_depth_.compare_exchange_weak(max_depth, depth)) {
+    }
+
+    std::lock_guard<std::mutex> lock(mtx);
+    if (sleeping_ > 0) {
+        cv_.notify_one();
+    }
+    return true;
+}
+
+// Own queue first, oldest job first; then the newest job of the others.
+bool BlockingPool::take(size_t index, Entry& entry) {
+    for (size_t i = 0; i < workers_.size(); i++) {
+        Worker& worker = *workers_[(index + i) % workers_.size()];
+        std::lock_guard<std::mutex> lock(worker.mtx);
+        if (worker.queue.empty()) {
+            continue;
+        }
+        if (i == 0) {
+            entry = std::move(worker.queue.front());
+            worker.queue.pop_front();
+        } else {
+            entry = std::move(worker.queue.back());
+            worker.queue.pop_back();
+            stolen_.fetch_add(1, std::memory_order_relaxed);
+        }
+        depth_.fetch_sub(1);
+        return true;
+    }
+    return false;
+}
+
+void BlockingPool::run_worker(size_t index) {
+    // Process signals belong to the loops, see EvLoop::add_signal().
+    sigset_t all;
+    sigfillset(&all);
+    pthread_sigmask(SIG_BLOCK, &all, nullptr);
+
+    Entry entry;
+    for (;;) {
+        if (take(index, entry)) {
+            auto start = Clock::now();
+            record(queue_wait_us_, start - entry.queued);
+            try {
+                entry.job();
+            } catch (const std::exception& e) {
+                std::cerr << "Exception in blocking job: " << e.what() << std::endl;
+            } catch (...) {
+                std::cerr << "Unknown exception in blocking job" << std::endl;
+            }
+            record(run_us_, Clock::now() - start);
+            completed_.fetch_add(1, std::memory_order_relaxed);
+            entry.job = nullptr;
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(mtx);
+        if (depth_.load() > 0) {
+            continue;
+        }
+        if (stop_.load()) {
+            return;
+        }
+        sleeping_++;
+        cv_.wait(lock, [this]() { return stop_.load() || depth_.load() > 0; });
+        sleeping_--;
+    }
+}
+
+void BlockingPool::record_completion(Clock::duration delay) {
+    record(completion_us_, delay);
+}
+
+void BlockingPool::record(std::atomic<uint64_t>* buckets, Clock::duration elapsed) {
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+    size_t bucket = us <= 0 ? 0 : 64 - __builtin_clzll(static_cast<uint64_t>(us));
+    buckets[std::min(bucket, BlockingPoolStats::LATENCY_BUCKETS - 1)].fetch_add(
+        1, std::memory_order_relaxed);
+}
+
+BlockingPoolStats BlockingPool::get_stats() const {
+    BlockingPoolStats stats;
+    stats.threads = workers_.size();
+    stats.depth = depth_.load(std::memory_order_relaxed);
+    stats.max_depth = max_depth_.load(std::memory_order_relaxed);
+    stats.submitted = submitted_.load(std::memory_order_relaxed);
+    stats.completed = completed_.load(std::memory_order_relaxed);
+    stats.stolen = stolen_.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < BlockingPoolStats::LATENCY_BUCKETS; i++) {
+        stats.queue_wait_us[i] = queue_wait_us_[i].load(std::memory_order_relaxed);
+        stats.run_us[i] = run_us_[i].load(std::memory_order_relaxed);
+        stats.completion_us[i] = completion_us_[i].load(std::memory_order_relaxed);
+    }
+    return stats;
+}
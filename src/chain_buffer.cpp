@@ -0,0 +1,151 @@
+#include <cerrno>
+#include <cstring>
+#include <algorithm>
+#include <unistd.h>
+#include <sys/socket.h>
+#include "chain_buffer.h"
+
+ChainBuffer::Chunk ChainBuffer::make_chunk() {
+    Chunk chunk;
+    if (!spare_.empty()) {
+        chunk.data = std::move(spare_.back());
+        spare_.pop_back();
+    } else {
+        chunk.data = std::make_unique<char[]>(CHUNK_SIZE);
+    }
+    return chunk;
+}
+
+void ChainBuffer::release_front() {
+    if (spare_.size() < MAX_SPARE) {
+        spare_.push_back(std::move(chunks_.front().data));
+    }
+    chunks_.pop_front();
+}
+
+void ChainBuffer::append(const void* data, size_t len) {
+    const char* src = static_cast<const char*>(data);
+    while (len > 0) {
+        if (chunks_.empty() || chunks_.back().end == CHUNK_SIZE) {
+            chunks_.push_back(make_chunk());
+        }
+        Chunk& tail = chunks_.back();
+        size_t n = std::min(len, CHUNK_SIZE - tail.end);
+        memcpy(tail.data.get() + tail.end, src, n);
+        tail.end += n;
+        size_ += n;
+        src += n;
+        len -= n;
+    }
+}
+
+std::string_view ChainBuffer::front() const {
+    if (chunks_.empty()) {
+        return {};
+    }
+    const Chunk& head = chunks_.front();
+    return {head.data.get() + head.begin, head.end - head.begin};
+}
+
+size_t ChainBuffer::copy_to(void* dst, size_t len) const {
+    char* out = static_cast<char*>(dst);
+    size_t copied = 0;
+    for (const Chunk& chunk : chunks_) {
+        if (copied == len) {
+            break;
+        }
+        size_t n = std::min(len - copied, chunk.end - chunk.begin);
+        memcpy(out + copied, chunk.data.get() + chunk.begin, n);
+        copied += n;
+    }
+    return copied;
+}
+
+void ChainBuffer::consume(size_t len) {
+    len = std::min(len, size_);
+    size_ -= len;
+    while (len > 0) {
+        Chunk& head = chunks_.front();
+        size_t n = std::min(len, head.end - head.begin);
+        head.begin += n;
+        len -= n;
+        if (head.begin == head.end) {
+            release_front();
+        }
+    }
+}
+
+std::string ChainBuffer::take(size_t len) {
+    std::string out(std::min(len, size_), '\0');
+    copy_to(out.data(), out.size());
+    consume(out.size());
+    return out;
+}
+
+void ChainBuffer::clear() {
+    while (!chunks_.empty()) {
+        release_front();
+    }
+    size_ = 0;
+}
+
+ssize_t ChainBuffer::read_fd(int fd) {
+    if (chunks_.empty() || chunks_.back().end == CHUNK_SIZE) {
+        chunks_.push_back(make_chunk());
+    }
+    Chunk extra = make_chunk();
+    Chunk& tail = chunks_.back();
+
+    iovec iov[2];
+    iov[0].iov_base = tail.data.get() + tail.end;
+    iov[0].iov_len = CHUNK_SIZE - tail.end;
+    iov[1].iov_base = extra.data.get();
+    iov[1].iov_len = CHUNK_SIZE;
+
+    ssize_t n = readv(fd, iov, 2);
+    if (n > 0) {
+        size_t first = std::min(static_cast<size_t>(n), iov[0].iov_len);
+        tail.end += first;
+        if (static_cast<size_t>(n) > first) {
+            extra.end = n - first;
+            chunks_.push_back(std::move(extra));
+        }
+        size_ += n;
+    }
+    if (extra.data && spare_.size() < MAX_SPARE) {
+        spare_.push_back(std::move(extra.data));
+    }
+    // Do not leave an empty chunk behind a failed read.
+    if (chunks_.size() == 1 && size_ == 0) {
+        clear();
+    }
+    return n;
+}
+
+ssize_t ChainBuffer::write_fd(int fd) {
+    iovec iov[MAX_IOV];
+    size_t count = 0;
+    for (const Chunk& chunk : chunks_) {
+        if (count == MAX_IOV) {
+            break;
+        }
+        iov[count].iov_base = chunk.data.get() + chunk.begin;
+        iov[count].iov_len = chunk.end - chunk.begin;
+        count++;
+    }
+    if (count == 0) {
+        return 0;
+    }
+
+    msghdr msg{};
+    msg.msg_iov = iov;
+    msg.msg_iovlen = count;
+    ssize_t n = sendmsg(fd, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+    if (n < 0 && errno == ENOTSOCK) {
+        n = writev(fd, iov, count);
+    }
+    if (n > 0) {
+        consume(n);
+    }
+    return n;
+}
@@ -0,0 +1,299 @@
+#include "connection.h"
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/socket.h>
+//#define DEBUG
+
+#ifdef DEBUG
+#define dbg(a...) do { \
+    std::cerr << "[DEBUG] " << __FILE__ << ":" << __LINE__ << ":" << __FUNCTION__ <<" "; \
+    fprintf(stderr, a); \
+    std::cerr << std::endl; \
+} while(0)
+#else
+#define dbg(fmt, ...) do { } while(0)
+#endif
+
+// The callback is moved out while it runs, so it may close the connection
+// or replace itself without destroying the callable under our feet. It is
+// put back unless its slot was set (callbacks_set bumped) or the connection
+// closed meanwhile.
+template <typename Lock>
+template <typename Callback, typename Arg>
+void BasicConnection<Lock>::dispatch(Callback& callback, const uint64_t& callbacks_set, Arg&& arg) {
+    if (!callback) {
+        return;
+    }
+    uint64_t generation = callbacks_set;
+    Callback running = std::move(callback);
+    callback = nullptr;
+    running(*this, std::forward<Arg>(arg));
+    if (fd_ >= 0 && !callback && generation == callbacks_set) {
+        callback = std::move(running);
+    }
+}
+
+template <typename Lock>
+void BasicConnection<Lock>::wake_read_waiter() {
+    ReadWaiter waiter = std::move(read_waiter_);
+    read_waiter_ = nullptr;
+    waiter();
+}
+
+template <typename Lock>
+BasicConnection<Lock>::BasicConnection(BasicPoller<Lock>& poller, int fd)
+    : poller_(poller), fd_(fd) {
+}
+
+// Only reached with the fd still open when the connection was never
+// started or the poller itself is being torn down, so the poller is left
+// alone.
+template <typename Lock>
+BasicConnection<Lock>::~BasicConnection() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+}
+
+template <typename Lock>
+void BasicConnection<Lock>::set_watermarks(size_t low, size_t high, WatermarkCallback on_high,
+                                           WatermarkCallback on_low) {
+    low_watermark_ = std::min(low, high);
+    high_watermark_ = high;
+    on_high_ = std::move(on_high);
+    on_low_ = std::move(on_low);
+    watermark_callbacks_set_++;
+    above_high_ = false;
+    check_high_watermark();
+}
+
+template <typename Lock>
+bool BasicConnection<Lock>::start() {
+    if (fd_ < 0 || registered_) {
+        return false;
+    }
+    auto self = this->shared_from_this();
+    auto callback = [self](int fd, short events, short revents) {
+        (void)fd;
+        (void)events;
+        self->handle_event(revents);
+    };
+    if (!poller_.add(fd_, events_, std::move(callback))) {
+        std::cerr << "Failed to register connection fd " << fd_ << std::endl;
+        return false;
+    }
+    registered_ = true;
+    return true;
+}
+
+// Only queues. Sends made from this connection's data callback are
+// flushed once it returns; any other send arms POLLOUT, so everything queued
+// until the socket is reported writable goes out in one writev.
+template <typename Lock>
+bool BasicConnection<Lock>::send(const void* data, size_t len) {
+    if (fd_ < 0 || shutdown_pending_) {
+        return false;
+    }
+    if (len == 0) {
+        return true;
+    }
+
+    output_.append(data, len);
+    if (!in_callback_) {
+        set_events(events_ | POLLOUT);
+    }
+    check_high_watermark();
+    return true;
+}
+
+template <typename Lock>
+void BasicConnection<Lock>::pause_reading() {
+    set_events(events_ & ~POLLIN);
+}
+
+template <typename Lock>
+void BasicConnection<Lock>::resume_reading() {
+    set_events(events_ | POLLIN);
+}
+
+template <typename Lock>
+void BasicConnection<Lock>::shutdown() {
+    if (fd_ < 0 || shutdown_pending_) {
+        return;
+    }
+    shutdown_pending_ = true;
+    if (output_.empty()) {
+        shutdown_write();
+    }
+}
+
+// A pipe has no half-close; its write end is simply closed.
+template <typename Lock>
+void BasicConnection<Lock>::shutdown_write() {
+    if (::shutdown(fd_, SHUT_WR) < 0 && errno == ENOTSOCK) {
+        handle_close(0);
+    }
+}
+
+template <typename Lock>
+void BasicConnection<Lock>::close() {
+    handle_close(0);
+}
+
+template <typename Lock>
+void BasicConnection<Lock>::handle_event(short revents) {
+    if (revents & POLLNVAL) {
+        handle_close(EBADF);
+        return;
+    }
+    if (revents & POLLERR) {
+        int error = 0;
+        socklen_t len = sizeof(error);
+        if (getsockopt(fd_, SOL_SOCKET, SO_ERROR, &error, &len) < 0 || error == 0) {
+            error = EIO;
+        }
+        handle_close(error);
+        return;
+    }
+    // A hangup is read as well, so buffered data and EOF are seen even while
+    // reading is paused.
+    if (revents & (POLLIN | POLLHUP)) {
+        handle_read();
+    }
+    if (fd_ >= 0 && (revents & POLLOUT)) {
+        handle_write();
+    }
+}
+
+// One read per wakeup keeps a busy connection from starving the others;
+// the backends are level triggered, so anything left is reported again.
+template <typename Lock>
+void BasicConnection<Lock>::handle_read() {
+    ssize_t n = input_.read_fd(fd_);
+    if (n > 0) {
+        in_callback_ = true;
+        if (read_waiter_) {
+            wake_read_waiter();
+        } else {
+            dispatch(on_data_, data_callbacks_set_, input_);
+        }
+        in_callback_ = false;
+        flush();
+    } else if (n == 0) {
+        handle_close(0);
+    } else if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+        handle_close(errno);
+    }
+}
+
+template <typename Lock>
+void BasicConnection<Lock>::handle_write() {
+    while (!output_.empty()) {
+        ssize_t n = output_.write_fd(fd_);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                handle_close(errno);
+                return;
+            }
+            break;
+        }
+    }
+
+    finish_write();
+}
+
+// A single write for what the data callback sent. While POLLOUT is armed
+// the output is left to handle_write().
+template <typename Lock>
+void BasicConnection<Lock>::flush() {
+    if (fd_ < 0 || output_.empty() || (events_ & POLLOUT)) {
+        return;
+    }
+    if (output_.write_fd(fd_) < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+        handle_close(errno);
+        return;
+    }
+    finish_write();
+}
+
+template <typename Lock>
+void BasicConnection<Lock>::finish_write() {
+    if (above_high_ && output_.size() <= low_watermark_) {
+        above_high_ = false;
+        dispatch(on_low_, watermark_callbacks_set_, output_.size());
+    }
+    if (fd_ < 0) {
+        return;
+    }
+    if (!output_.empty()) {
+        set_events(events_ | POLLOUT);
+        return;
+    }
+    set_events(events_ & ~POLLOUT);
+    if (shutdown_pending_) {
+        shutdown_write();
+    }
+}
+
+template <typename Lock>
+void BasicConnection<Lock>::handle_close(int error) {
+    if (fd_ < 0) {
+        return;
+    }
+    auto self = this->shared_from_this();
+    if (registered_) {
+        poller_.remove(fd_);
+        registered_ = false;
+    }
+    ::close(fd_);
+    fd_ = -1;
+    output_.clear();
+
+    CloseCallback on_close = std::move(on_close_);
+    on_close_ = nullptr;
+    drop_callbacks();
+    if (read_waiter_) {
+        wake_read_waiter();
+    }
+    if (on_close) {
+        on_close(*this, error);
+    }
+}
+
+// Callbacks often hold a reference to the connection; dropping them once it
+// is closed breaks that cycle.
+template <typename Lock>
+void BasicConnection<Lock>::drop_callbacks() {
+    on_data_ = nullptr;
+    on_high_ = nullptr;
+    on_low_ = nullptr;
+}
+
+template <typename Lock>
+void BasicConnection<Lock>::set_events(short events) {
+    if (events == events_) {
+        return;
+    }
+    events_ = events;
+    if (registered_ && !poller_.update_events(fd_, events_)) {
+        std::cerr << "Failed to update events for fd " << fd_ << std::endl;
+    }
+}
+
+template <typename Lock>
+void BasicConnection<Lock>::check_high_watermark() {
+    if (high_watermark_ == 0 || above_high_ || output_.size() < high_watermark_) {
+        return;
+    }
+    above_high_ = true;
+    dispatch(on_high_, watermark_callbacks_set_, output_.size());
+}
+
+template class BasicConnection<ThreadSafe>;
+template class BasicConnection<NoLock>;
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string_view>
+#include "poller.h"
+#include "chain_buffer.h"
+
+// Non-blocking stream connection on a Poller. Incoming bytes collect in a
+// chained input buffer. send() only queues: whatever the data callback
+// sends is flushed with a single writev once it returns, and sends from
+// anywhere else wait for the socket to be reported writable. POLLOUT is only
+// armed while output is pending.
+//
+// Must be owned by a std::shared_ptr: while the fd is registered the poller
+// keeps the connection alive, so a callback may close it and drop every
+// other reference. Use it from the loop thread only.
+template <typename Lock>
+class BasicConnection: public std::enable_shared_from_this<BasicConnection<Lock>> {
+public:
+    // Called after a read with everything received so far. Bytes left in
+    // the buffer stay there for the next call.
+    using DataCallback = std::function<void(BasicConnection& conn, ChainBuffer& input)>;
+    // error is 0 for an orderly close by the peer or by close().
+    using CloseCallback = std::function<void(BasicConnection& conn, int error)>;
+    using WatermarkCallback = std::function<void(BasicConnection& conn, size_t pending)>;
+    using ReadWaiter = std::function<void()>;
+
+    // Takes ownership of fd, which must be non-blocking.
+    BasicConnection(BasicPoller<Lock>& poller, int fd);
+    ~BasicConnection();
+
+    BasicConnection(const BasicConnection&) = delete;
+    BasicConnection& operator=(const BasicConnection&) = delete;
+
+    // Callbacks may be replaced from inside a callback, including their own.
+    void set_data_callback(DataCallback callback) {
+        on_data_ = std::move(callback);
+        data_callbacks_set_++;
+    }
+
+    void set_close_callback(CloseCallback callback) { on_close_ = std::move(callback); }
+
+    // One-shot hook for a coroutine awaiting input, see coro.h. The next
+    // read runs it instead of the data callback; a close runs it before the
+    // close callback. The other callbacks are left in place.
+    void set_read_waiter(ReadWaiter waiter) { read_waiter_ = std::move(waiter); }
+
+    // on_high fires when the output queue grows to high bytes, on_low once
+    // it has drained back to low. A zero high disables both.
+    void set_watermarks(size_t low, size_t high, WatermarkCallback on_high,
+                        WatermarkCallback on_low);
+
+    // Registers the fd with the poller.
+    bool start();
+
+    bool send(const void* data, size_t len);
+
+    bool send(std::string_view data) { return send(data.data(), data.size()); }
+
+    // Stop and resume reading, e.g. while a peer is over its high watermark.
+    void pause_reading();
+
+    void resume_reading();
+
+    // Half-closes the write side once the output queue has drained, or
+    // closes the connection if it is a pipe.
+    void shutdown();
+
+    // Drops pending output, unregisters and closes the fd, then runs the
+    // close callback.
+    void close();
+
+    int fd() const { return fd_; }
+
+    bool is_open() const { return fd_ >= 0; }
+
+    size_t pending() const { return output_.size(); }
+
+    ChainBuffer& input() { return input_; }
+
+private:
+    BasicPoller<Lock>& poller_;
+    int fd_;
+    short events_{POLLIN};
+    bool registered_{false};
+    bool shutdown_pending_{false};
+    bool above_high_{false};
+    // Set while the data callback or read waiter runs; their sends are
+    // flushed together afterwards.
+    bool in_callback_{false};
+    // Bumped by the setters, so a callback that replaces or clears itself
+    // is not put back by dispatch().
+    uint64_t data_callbacks_set_{0};
+    uint64_t watermark_callbacks_set_{0};
+    size_t low_watermark_{0};
+    size_t high_watermark_{0};
+    ChainBuffer input_;
+    ChainBuffer output_;
+    DataCallback on_data_;
+    CloseCallback on_close_;
+    WatermarkCallback on_high_;
+    WatermarkCallback on_low_;
+    ReadWaiter read_waiter_;
+
+    void handle_event(short revents);
+
+    void handle_read();
+
+    void handle_write();
+
+    void flush();
+
+    void finish_write();
+
+    void handle_close(int error);
+
+    void shutdown_write();
+
+    void set_events(short events);
+
+    void check_high_watermark();
+
+    void drop_callbacks();
+
+    template <typename Callback, typename Arg>
+    void dispatch(Callback& callback, const uint64_t& callbacks_set, Arg&& arg);
+
+    void wake_read_waiter();
+};
+
+using Connection = BasicConnection<ThreadSafe>;
+using LocalConnection = BasicConnection<NoLock>;
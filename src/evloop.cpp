@@ -6,6 +6,12 @@
 #include <cerrno>
 #include <fcntl.h>
 #include <unistd.h>
+#include <sys/timerfd.h>
+#include <sys/signalfd.h>
+#include <pthread.h>
+#include <spawn.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
 //#define DEBUG
 
 #ifdef DEBUG
@@ -18,46 +24,677 @@
 #define dbg(fmt, ...) do { } while(0)
 #endif
 
-EvLoop::EvLoop() {
-
+template <typename Lock>
+BasicEvLoop<Lock>::BasicEvLoop(BackendType backend): BasicPoller<Lock>(backend),
+    frame_pool_(std::make_unique<FramePool>()) {
+    sigemptyset(&signal_mask_);
+    sigemptyset(&blocked_signals_);
+    if (!this->exact_timeouts()) {
+        create_timer_fd();
+    }
 }
 
-EvLoop::~EvLoop() {
+template <typename Lock>
+BasicEvLoop<Lock>::~BasicEvLoop() {
     stop();
+    // Blocking work still running would post its completion to us.
+    {
+        std::unique_lock<std::mutex> lock(blocking_mtx);
+        blocking_cv_.wait(lock, [this]() { return blocking_inflight_.load() == 0; });
+    }
+    watchdog_.reset();
+    if (timer_fd_ >= 0) {
+        this->remove(timer_fd_);
+        close(timer_fd_);
+    }
+    if (signal_fd_ >= 0) {
+        this->remove(signal_fd_);
+        close(signal_fd_);
+    }
+}
+
+template <typename Lock>
+void BasicEvLoop<Lock>::create_timer_fd() {
+    timer_fd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timer_fd_ < 0) {
+        dbg("Failed to create timerfd: %s", strerror(errno));
+        return;
+    }
+
+    auto callback = [this](int fd, short events, short revents) {
+        (void)events;
+        (void)revents;
+        uint64_t expirations;
+        if (read(fd, &expirations, sizeof(expirations)) < 0) {
+            dbg("Failed to read timerfd: %s", strerror(errno));
+        }
+        timer_fd_deadline_ = TimePoint();
+    };
+
+    if (!this->add(timer_fd_, POLLIN, callback)) {
+        close(timer_fd_);
+        timer_fd_ = -1;
+    }
 }
 
-void EvLoop::run(int default_timeout_ms) {
-    start();
-    while (is_running()) {
-        int timeout = calculate_timeout(default_timeout_ms);
+// Sub-millisecond waits are handed to the timerfd, which is not subject to
+// timer slack. The wait itself only keeps a coarse fallback timeout.
+template <typename Lock>
+std::chrono::nanoseconds BasicEvLoop<Lock>::precise_timeout(std::chrono::nanoseconds timeout) {
+    if (timer_fd_ < 0 || timeout.count() <= 0 || timeout >= std::chrono::milliseconds(1)) {
+        return timeout;
+    }
+
+    TimePoint deadline = this->next_deadline();
+    if (deadline != timer_fd_deadline_) {
+        auto since_epoch = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            deadline.time_since_epoch()).count();
+        itimerspec spec{};
+        spec.it_value.tv_sec = since_epoch / 1000000000L;
+        spec.it_value.tv_nsec = since_epoch % 1000000000L;
+        if (timerfd_settime(timer_fd_, TFD_TIMER_ABSTIME, &spec, nullptr) < 0) {
+            dbg("Failed to arm timerfd: %s", strerror(errno));
+            return timeout;
+        }
+        timer_fd_deadline_ = deadline;
+    }
+    return timeout + std::chrono::milliseconds(1);
+}
 
-        int result = poll(timeout);
+template <typename Lock>
+void BasicEvLoop<Lock>::run(int default_timeout_ms) {
+    auto self = std::this_thread::get_id();
+    this->BasicTimer<Lock>::set_owner_thread(self);
+    this->BasicPoller<Lock>::set_owner_thread(self);
+    this->start();
+    FramePool::Scope frames(*frame_pool_);
+    // Signals added while running are blocked by add_signal() itself; the
+    // thread gets its own mask back on return.
+    sigset_t saved_mask;
+    pthread_sigmask(SIG_BLOCK, &signal_mask_, &saved_mask);
+    if (watchdog_) {
+        watchdog_->attach(pthread_self());
+    }
+    std::chrono::nanoseconds default_timeout(-1);
+    if (default_timeout_ms >= 0) {
+        default_timeout = std::chrono::milliseconds(default_timeout_ms);
+    }
+    // Set when the previous wait ended without any event, so a loop kept
+    // busy by its fds never runs the idle hooks.
+    bool idle = false;
+    while (this->is_running()) {
+        if (idle && !idle_hooks_.empty() && tasks_.empty() && deferred_.empty()) {
+            run_hooks(idle_hooks_);
+        }
+        run_hooks(prepare_hooks_);
+        auto timeout = tasks_.empty() && deferred_.empty()
+            ? precise_timeout(this->calculate_timeout(default_timeout))
+            : std::chrono::nanoseconds::zero();
+
+        if (stats_enabled_.load(std::memory_order_relaxed)) {
+            counters_.record_iteration();
+        }
+        int result = this->poll(timeout);
         if (result < 0 && errno != EINTR) {
             break;
         }
-        process_timers();
+        idle = result == 0;
+        this->process_timers();
+        run_posted();
+        run_deferred();
+        run_hooks(check_hooks_);
+    }
+    counters_.set_idle();
+    if (watchdog_) {
+        watchdog_->detach();
     }
+    pthread_sigmask(SIG_SETMASK, &saved_mask, nullptr);
+    this->BasicTimer<Lock>::set_owner_thread(std::thread::id());
+    this->BasicPoller<Lock>::set_owner_thread(std::thread::id());
+}
+
+template <typename Lock>
+void BasicEvLoop<Lock>::stop() {
+    this->BasicPoller<Lock>::stop();
 }
 
-void EvLoop::stop() {
-    this->Poller::stop();
+template <typename Lock>
+int BasicEvLoop<Lock>::add_timer(int interval_ms, TimerCallback callback, bool repeat, TimerMode mode) {
+    return add_timer(std::chrono::milliseconds(interval_ms), std::move(callback), repeat, mode);
 }
 
-int EvLoop::add_timer(int interval_ms, TimerCallback callback, bool repeat) {
-int  ret = this->Timer::add_timer(interval_ms, callback, repeat);
-    trigger_loop();
+template <typename Lock>
+int BasicEvLoop<Lock>::add_timer(std::chrono::nanoseconds interval, TimerCallback callback,
+                                 bool repeat, TimerMode mode) {
+    return add_timer(interval, std::chrono::nanoseconds::zero(), std::move(callback), repeat, mode);
+}
+
+template <typename Lock>
+int BasicEvLoop<Lock>::add_timer(std::chrono::nanoseconds interval, std::chrono::nanoseconds slack,
+                                 TimerCallback callback, bool repeat, TimerMode mode) {
+int  ret = this->BasicTimer<Lock>::add_timer(interval, slack, std::move(callback), repeat, mode);
+    if (Lock::thread_safe)
+        this->trigger_loop();
     return ret;
 }
 
-bool EvLoop::remove_timer(int timer_id) {
-bool ret = this->Timer::remove_timer(timer_id);
-    trigger_loop();
+template <typename Lock>
+bool BasicEvLoop<Lock>::remove_timer(int timer_id) {
+bool ret = this->BasicTimer<Lock>::remove_timer(timer_id);
+    if (Lock::thread_safe)
+        this->trigger_loop();
     return ret;
 }
 
-bool EvLoop::update_timer_interval(int timer_id, int interval_ms) {
-bool ret = this->Timer::update_timer_interval(timer_id, interval_ms);
-    trigger_loop();
+template <typename Lock>
+bool BasicEvLoop<Lock>::update_timer_interval(int timer_id, int interval_ms) {
+    return update_timer_interval(timer_id, std::chrono::milliseconds(interval_ms));
+}
+
+template <typename Lock>
+bool BasicEvLoop<Lock>::update_timer_interval(int timer_id, std::chrono::nanoseconds interval) {
+bool ret = this->BasicTimer<Lock>::update_timer_interval(timer_id, interval);
+    if (Lock::thread_safe)
+        this->trigger_loop();
     return ret;
 }
 
+
+template <typename Lock>
+void BasicEvLoop<Lock>::post(Task task) {
+    if (!task) {
+        return;
+    }
+    tasks_.push(std::move(task));
+    this->trigger_loop();
+}
+
+template <typename Lock>
+void BasicEvLoop<Lock>::post_batch(std::vector<Task> tasks) {
+    if (tasks_.push_batch(tasks.begin(), tasks.end()) > 0) {
+        this->trigger_loop();
+    }
+}
+
+template <typename Lock>
+void BasicEvLoop<Lock>::invoke(Task& task, const char* what) {
+    LoopCounters* stats = stats_enabled_.load(std::memory_order_relaxed) ? &counters_ : nullptr;
+    LoopCounters::Clock::time_point start;
+    if (stats) {
+        start = LoopCounters::Clock::now();
+    }
+    try {
+        task();
+    } catch (const std::exception& e) {
+        std::cerr << "Exception in " << what << ": " << e.what() << std::endl;
+    } catch (...) {
+        std::cerr << "Unknown exception in " << what << std::endl;
+    }
+    if (stats) {
+        stats->record_callback(LoopCounters::Clock::now() - start, -1, -1);
+    }
+}
+
+template <typename Lock>
+void BasicEvLoop<Lock>::run_posted() {
+    tasks_.consume([this](Task& task) {
+        invoke(task, "posted task");
+    });
+}
+
+template <typename Lock>
+void BasicEvLoop<Lock>::defer(Task callback) {
+    if (callback) {
+        deferred_.push_back(std::move(callback));
+    }
+}
+
+template <typename Lock>
+void BasicEvLoop<Lock>::run_deferred() {
+    if (deferred_.empty()) {
+        return;
+    }
+    running_deferred_.swap(deferred_);
+    for (auto& callback : running_deferred_) {
+        invoke(callback, "deferred callback");
+    }
+    running_deferred_.clear();
+}
+
+template <typename Lock>
+int BasicEvLoop<Lock>::add_idle(Task hook) {
+    return add_hook(idle_hooks_, std::move(hook));
+}
+
+template <typename Lock>
+int BasicEvLoop<Lock>::add_prepare(Task hook) {
+    return add_hook(prepare_hooks_, std::move(hook));
+}
+
+template <typename Lock>
+int BasicEvLoop<Lock>::add_check(Task hook) {
+    return add_hook(check_hooks_, std::move(hook));
+}
+
+template <typename Lock>
+int BasicEvLoop<Lock>::add_hook(std::vector<Hook>& hooks, Task hook) {
+    if (!hook) {
+        return -1;
+    }
+    int id = next_hook_id_++;
+    hooks.push_back({id, std::move(hook), false});
+    return id;
+}
+
+// While hooks run, removed ones are only marked so the indices stay valid.
+template <typename Lock>
+bool BasicEvLoop<Lock>::remove_hook(int hook_id) {
+    for (auto* hooks : {&idle_hooks_, &prepare_hooks_, &check_hooks_}) {
+        for (auto it = hooks->begin(); it != hooks->end(); ++it) {
+            if (it->id != hook_id || it->removed) {
+                continue;
+            }
+            if (running_hooks_) {
+                it->removed = true;
+                it->callback = nullptr;
+            } else {
+                hooks->erase(it);
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+// A hook is moved out while it runs, like fd callbacks, and put back unless
+// it was removed meanwhile. Hooks added by a hook run from the next pass on.
+template <typename Lock>
+void BasicEvLoop<Lock>::run_hooks(std::vector<Hook>& hooks) {
+    if (hooks.empty()) {
+        return;
+    }
+    running_hooks_ = true;
+    size_t count = hooks.size();
+    bool removed = false;
+    for (size_t i = 0; i < count; i++) {
+        if (hooks[i].removed) {
+            removed = true;
+            continue;
+        }
+        Task callback = std::move(hooks[i].callback);
+        invoke(callback, "hook");
+        if (hooks[i].removed) {
+            removed = true;
+        } else {
+            hooks[i].callback = std::move(callback);
+        }
+    }
+    running_hooks_ = false;
+    if (removed) {
+        hooks.erase(std::remove_if(hooks.begin(), hooks.end(),
+                                   [](const Hook& hook) { return hook.removed; }),
+                    hooks.end());
+    }
+}
+
+template <typename Lock>
+bool BasicEvLoop<Lock>::submit_blocking(Task work, Task done) {
+    if (!work) {
+        return false;
+    }
+    BlockingPool& pool = blocking_pool();
+    blocking_inflight_++;
+    auto job = [this, &pool, work = std::move(work), done = std::move(done)]() mutable {
+        try {
+            work();
+        } catch (const std::exception& e) {
+            std::cerr << "Exception in blocking work: " << e.what() << std::endl;
+        } catch (...) {
+            std::cerr << "Unknown exception in blocking work" << std::endl;
+        }
+        if (done) {
+            auto finished = BlockingPool::Clock::now();
+            post([&pool, finished, done = std::move(done)]() {
+                pool.record_completion(BlockingPool::Clock::now() - finished);
+                done();
+            });
+        }
+        // Under the lock, so the destructor cannot return in between and
+        // free the condition variable while it is signalled.
+        std::lock_guard<std::mutex> lock(blocking_mtx);
+        if (--blocking_inflight_ == 0) {
+            blocking_cv_.notify_all();
+        }
+    };
+    if (!pool.submit(std::move(job))) {
+        blocking_inflight_--;
+        return false;
+    }
+    return true;
+}
+
+template <typename Lock>
+void BasicEvLoop<Lock>::enable_stats(std::chrono::milliseconds dump_interval, StatsCallback dump) {
+    stats_enabled_.store(true, std::memory_order_relaxed);
+    this->BasicTimer<Lock>::set_stats(&counters_);
+    this->BasicPoller<Lock>::set_stats(&counters_);
+
+    if (stats_timer_id_ >= 0) {
+        remove_timer(stats_timer_id_);
+        stats_timer_id_ = -1;
+    }
+    if (dump_interval.count() <= 0) {
+        return;
+    }
+    stats_timer_id_ = add_timer(dump_interval, dump_interval / 10,
+                                [this, dump = std::move(dump)](int timer_id) {
+        (void)timer_id;
+        LoopStats stats = counters_.snapshot();
+        if (dump) {
+            dump(stats);
+        } else {
+            std::cout << stats.to_json() << std::endl;
+        }
+    });
+}
+
+template <typename Lock>
+void BasicEvLoop<Lock>::disable_stats() {
+    stats_enabled_.store(false, std::memory_order_relaxed);
+    // The watchdog still needs the busy state the counters carry.
+    if (!watchdog_) {
+        this->BasicTimer<Lock>::set_stats(nullptr);
+        this->BasicPoller<Lock>::set_stats(nullptr);
+    }
+    if (stats_timer_id_ >= 0) {
+        remove_timer(stats_timer_id_);
+        stats_timer_id_ = -1;
+    }
+}
+
+template <typename Lock>
+LoopStats BasicEvLoop<Lock>::get_stats() const {
+    return counters_.snapshot();
+}
+
+template <typename Lock>
+void BasicEvLoop<Lock>::enable_watchdog(std::chrono::milliseconds threshold, StallCallback hook,
+                                        int backtrace_signal) {
+    if (threshold.count() <= 0 || !hook) {
+        std::cerr << "Invalid watchdog threshold or hook" << std::endl;
+        return;
+    }
+    watchdog_.reset();
+    this->BasicTimer<Lock>::set_stats(&counters_);
+    this->BasicPoller<Lock>::set_stats(&counters_);
+    watchdog_ = std::make_unique<LoopWatchdog>(counters_, threshold, std::move(hook), backtrace_signal);
+}
+
+template <typename Lock>
+void BasicEvLoop<Lock>::disable_watchdog() {
+    watchdog_.reset();
+    if (!stats_enabled_.load(std::memory_order_relaxed)) {
+        this->BasicTimer<Lock>::set_stats(nullptr);
+        this->BasicPoller<Lock>::set_stats(nullptr);
+    }
+}
+
+template <typename Lock>
+bool BasicEvLoop<Lock>::add_signal(int signo, SignalCallback callback) {
+    if (signo <= 0 || signo >= NSIG || signo == SIGKILL || signo == SIGSTOP || !callback) {
+        std::cerr << "Invalid signal " << signo << std::endl;
+        return false;
+    }
+
+    sigset_t mask = signal_mask_;
+    sigaddset(&mask, signo);
+    sigset_t old_mask;
+    int error = pthread_sigmask(SIG_BLOCK, &mask, &old_mask);
+    if (error != 0) {
+        std::cerr << "Failed to block signal " << signo << ": " << strerror(error) << std::endl;
+        return false;
+    }
+    if (!sigismember(&old_mask, signo)) {
+        sigaddset(&blocked_signals_, signo);
+    }
+    int fd = signalfd(signal_fd_, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (fd < 0) {
+        perror("signalfd");
+        unblock_signal(signo);
+        return false;
+    }
+    if (signal_fd_ < 0) {
+        auto handler = [this](int fd, short events, short revents) {
+            (void)fd;
+            (void)events;
+            (void)revents;
+            handle_signals();
+        };
+        if (!this->add(fd, POLLIN, handler)) {
+            close(fd);
+            unblock_signal(signo);
+            return false;
+        }
+        signal_fd_ = fd;
+    }
+    signal_mask_ = mask;
+    signal_handlers_[signo] = std::move(callback);
+    return true;
+}
+
+template <typename Lock>
+bool BasicEvLoop<Lock>::remove_signal(int signo) {
+    auto it = signal_handlers_.find(signo);
+    if (it == signal_handlers_.end()) {
+        return false;
+    }
+    signal_handlers_.erase(it);
+    sigdelset(&signal_mask_, signo);
+    if (signalfd(signal_fd_, &signal_mask_, SFD_NONBLOCK | SFD_CLOEXEC) < 0) {
+        perror("signalfd");
+    }
+    unblock_signal(signo);
+    return true;
+}
+
+// Only undoes what add_signal() blocked, so a signal the caller had blocked
+// beforehand stays blocked.
+template <typename Lock>
+void BasicEvLoop<Lock>::unblock_signal(int signo) {
+    if (signal_handlers_.count(signo) || !sigismember(&blocked_signals_, signo)) {
+        return;
+    }
+    sigdelset(&blocked_signals_, signo);
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, signo);
+    pthread_sigmask(SIG_UNBLOCK, &mask, nullptr);
+}
+
+// Drains the signalfd and runs each handler once, with the number of
+// deliveries of its signal. Standard signals are already merged while
+// pending; queued real-time signals are merged here.
+template <typename Lock>
+void BasicEvLoop<Lock>::handle_signals() {
+    uint32_t counts[NSIG] = {};
+    signalfd_siginfo info[16];
+    for (;;) {
+        ssize_t n = read(signal_fd_, info, sizeof(info));
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                std::cerr << "Failed to read signalfd: " << strerror(errno) << std::endl;
+            }
+            break;
+        }
+        for (size_t i = 0; i < n / sizeof(signalfd_siginfo); i++) {
+            if (info[i].ssi_signo < static_cast<uint32_t>(NSIG)) {
+                counts[info[i].ssi_signo]++;
+            }
+        }
+        if (static_cast<size_t>(n) < sizeof(info)) {
+            break;
+        }
+    }
+
+    for (int signo = 1; signo < NSIG; signo++) {
+        if (counts[signo] == 0) {
+            continue;
+        }
+        auto it = signal_handlers_.find(signo);
+        if (it == signal_handlers_.end() || !it->second) {
+            continue;
+        }
+        // Moved out so the handler may remove or replace itself.
+        SignalCallback callback = std::move(it->second);
+        callback(signo, counts[signo]);
+        it = signal_handlers_.find(signo);
+        if (it != signal_handlers_.end() && !it->second) {
+            it->second = std::move(callback);
+        }
+    }
+}
+
+template <typename Lock>
+bool BasicEvLoop<Lock>::watch_child(pid_t pid, ExitCallback callback) {
+    if (pid <= 0 || !callback) {
+        return false;
+    }
+    // Close-on-exec by default.
+    int pidfd = syscall(SYS_pidfd_open, pid, 0);
+    if (pidfd < 0) {
+        perror("pidfd_open");
+        return false;
+    }
+
+    auto handler = [this, pid, callback = std::move(callback)](int fd, short events, short revents) {
+        (void)events;
+        (void)revents;
+        int status = 0;
+        pid_t ret;
+        do {
+            ret = waitpid(pid, &status, WNOHANG);
+        } while (ret < 0 && errno == EINTR);
+        if (ret == 0) {
+            return;
+        }
+        if (ret < 0) {
+            dbg("waitpid %d failed: %s", pid, strerror(errno));
+            status = -1;
+        }
+        this->remove(fd);
+        close(fd);
+        callback(pid, status);
+    };
+    if (!this->add(pidfd, POLLIN, std::move(handler))) {
+        close(pidfd);
+        return false;
+    }
+    return true;
+}
+
+template <typename Lock>
+typename BasicEvLoop<Lock>::Child BasicEvLoop<Lock>::spawn(const std::vector<std::string>& argv,
+                                                           OutputCallback on_stdout,
+                                                           OutputCallback on_stderr,
+                                                           ExitCallback on_exit) {
+    Child child;
+    if (argv.empty()) {
+        return child;
+    }
+
+    // pipes[i] is {read end, write end} for the child's fd i.
+    int pipes[3][2] = {{-1, -1}, {-1, -1}, {-1, -1}};
+    bool piped[3] = {true, static_cast<bool>(on_stdout), static_cast<bool>(on_stderr)};
+    auto close_pipes = [&pipes]() {
+        for (auto& ends : pipes) {
+            for (int& fd : ends) {
+                if (fd >= 0) {
+                    close(fd);
+                    fd = -1;
+                }
+            }
+        }
+    };
+    for (int i = 0; i < 3; i++) {
+        if (piped[i] && pipe2(pipes[i], O_CLOEXEC) < 0) {
+            perror("pipe2");
+            close_pipes();
+            return child;
+        }
+    }
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    for (int i = 0; i < 3; i++) {
+        if (piped[i]) {
+            posix_spawn_file_actions_adddup2(&actions, pipes[i][i == 0 ? 0 : 1], i);
+        }
+    }
+    // The loop may block signals for its signalfd; the child starts clean.
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    sigset_t empty;
+    sigemptyset(&empty);
+    posix_spawnattr_setsigmask(&attr, &empty);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK);
+
+    std::vector<char*> args;
+    for (const auto& arg : argv) {
+        args.push_back(const_cast<char*>(arg.c_str()));
+    }
+    args.push_back(nullptr);
+    pid_t pid = -1;
+    int error = posix_spawnp(&pid, args[0], &actions, &attr, args.data(), environ);
+    posix_spawn_file_actions_destroy(&actions);
+    posix_spawnattr_destroy(&attr);
+
+    for (int i = 0; i < 3; i++) {
+        int& end = pipes[i][i == 0 ? 0 : 1];
+        if (end >= 0) {
+            close(end);
+            end = -1;
+        }
+    }
+    if (error != 0) {
+        std::cerr << "Failed to spawn " << argv[0] << ": " << strerror(error) << std::endl;
+        close_pipes();
+        return child;
+    }
+
+    child.pid = pid;
+    std::shared_ptr<BasicConnection<Lock>>* ends[3] = {&child.in, &child.out, &child.err};
+    OutputCallback* callbacks[3] = {nullptr, &on_stdout, &on_stderr};
+    for (int i = 0; i < 3; i++) {
+        if (!piped[i]) {
+            continue;
+        }
+        int fd = pipes[i][i == 0 ? 1 : 0];
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        auto conn = std::make_shared<BasicConnection<Lock>>(*this, fd);
+        if (callbacks[i]) {
+            conn->set_data_callback(std::move(*callbacks[i]));
+        }
+        if (!conn->start()) {
+            conn->close();
+        }
+        *ends[i] = std::move(conn);
+    }
+    // Watched even without a callback, so the child does not linger as a
+    // zombie.
+    if (!on_exit) {
+        on_exit = [](pid_t pid, int status) {
+            (void)pid;
+            (void)status;
+        };
+    }
+    if (!watch_child(pid, std::move(on_exit))) {
+        std::cerr << "Failed to watch child " << pid << std::endl;
+    }
+    return child;
+}
+
+template class BasicEvLoop<ThreadSafe>;
+template class BasicEvLoop<NoLock>;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <poll.h>
+#include <signal.h>
 #include <functional>
 #include <unordered_map>
 #include <vector>
@@ -10,32 +11,226 @@
 #include <set>
 #include <list>
 #include <mutex>
+#include <condition_variable>
 #include <shared_mutex>
+#include <string>
 #include "poller.h"
 #include "timer.h"
+#include "mpsc_queue.h"
+#include "watchdog.h"
+#include "frame_pool.h"
+#include "connection.h"
+#include "blocking_pool.h"
 
-class EvLoop: public Timer, public Poller {
+template <typename Lock>
+class BasicEvLoop: public BasicTimer<Lock>, public BasicPoller<Lock> {
 public:
+    using Task = std::function<void()>;
+    using TimerCallback = typename BasicTimer<Lock>::TimerCallback;
+    using FdCallback = typename BasicPoller<Lock>::FdCallback;
+    using IoCallback = typename BasicPoller<Lock>::IoCallback;
 
-    EvLoop();
-    ~EvLoop();
+    explicit BasicEvLoop(BackendType backend = BackendType::POLL);
+    ~BasicEvLoop();
 
-    EvLoop(const EvLoop&) = delete;
-    EvLoop& operator=(const EvLoop&) = delete;
+    BasicEvLoop(const BasicEvLoop&) = delete;
+    BasicEvLoop& operator=(const BasicEvLoop&) = delete;
 
-    EvLoop(EvLoop&&) = default;
-    EvLoop& operator=(EvLoop&&) = default;
+    BasicEvLoop(BasicEvLoop&&) = default;
+    BasicEvLoop& operator=(BasicEvLoop&&) = default;
 
     void run(int default_timeout_ms = 1000);
 
     void stop();
 
-    int add_timer(int interval_ms, TimerCallback callback, bool repeat = true);
+    int add_timer(int interval_ms, TimerCallback callback, bool repeat = true,
+                  TimerMode mode = TimerMode::QUEUE);
+
+    int add_timer(std::chrono::nanoseconds interval, TimerCallback callback, bool repeat = true,
+                  TimerMode mode = TimerMode::QUEUE);
+
+    int add_timer(std::chrono::nanoseconds interval, std::chrono::nanoseconds slack,
+                  TimerCallback callback, bool repeat = true, TimerMode mode = TimerMode::QUEUE);
 
     bool remove_timer(int timer_id);
 
     bool update_timer_interval(int timer_id, int interval_ms);
 
- 
+    bool update_timer_interval(int timer_id, std::chrono::nanoseconds interval);
+
+    // Thread-safe with either lock policy. Tasks run on the loop thread once
+    // per iteration, in posting order.
+    void post(Task task);
+
+    void post_batch(std::vector<Task> tasks);
+
+    // Runs callback at the end of the current iteration, after its fd
+    // events, timers and posted tasks, so work several events ask for (e.g.
+    // flushing output) is done once. Callbacks deferred by a deferred
+    // callback run in the next iteration. Call from the loop thread.
+    void defer(Task callback);
+
+    // Hooks run on the loop's iterations until removed. Idle hooks run
+    // only after a wait that ended without any event, with nothing posted
+    // or deferred, so a loop saturated with events never runs them and a
+    // quiet one runs them once per timeout or timer; prepare hooks run
+    // right before the loop computes its timeout and waits; check hooks
+    // after the deferred callbacks. A hook may add or remove hooks,
+    // including itself. Returns an id for remove_hook(). Call from the loop
+    // thread or before run().
+    int add_idle(Task hook);
+
+    int add_prepare(Task hook);
+
+    int add_check(Task hook);
+
+    bool remove_hook(int hook_id);
+
+    using StatsCallback = std::function<void(const LoopStats& stats)>;
+
+    // Starts recording LoopStats. A non-zero dump_interval arms a timer that
+    // hands a snapshot to dump, or prints it as a JSON line when dump is
+    // empty. Call from the loop thread or before run().
+    void enable_stats(std::chrono::milliseconds dump_interval = std::chrono::milliseconds::zero(),
+                      StatsCallback dump = nullptr);
+
+    void disable_stats();
+
+    // Safe to call from any thread.
+    LoopStats get_stats() const;
+
+    using StallCallback = LoopWatchdog::StallCallback;
+
+    // Starts a watchdog thread that calls hook when a single iteration runs
+    // longer than threshold. A non-zero backtrace_signal also captures the
+    // loop thread's stack through that signal. Call before run().
+    void enable_watchdog(std::chrono::milliseconds threshold, StallCallback hook,
+                         int backtrace_signal = 0);
+
+    void disable_watchdog();
+
+    // Called with the signal and how many deliveries were coalesced into
+    // this call.
+    using SignalCallback = SmallFunction<void(int signo, uint32_t count)>;
+
+    // Delivers signo through a signalfd as a regular loop event. The signal
+    // is blocked on the calling thread and, while run() lasts, on the thread
+    // running the loop. Add signals before creating other threads so they
+    // inherit the mask, or a thread that has it unblocked gets the default
+    // action instead.
+    // A signal is only seen by one loop. Call from the loop thread or
+    // before run().
+    bool add_signal(int signo, SignalCallback callback);
+
+    // Stops delivering signo. It is unblocked on the calling thread only if
+    // add_signal() blocked it there; the loop thread gets its old mask back
+    // only when run() returns.
+    bool remove_signal(int signo);
+
+    // Gets the raw waitpid status, or -1 if the child was reaped elsewhere.
+    using ExitCallback = std::function<void(pid_t pid, int status)>;
+    using OutputCallback = typename BasicConnection<Lock>::DataCallback;
+
+    // Reaps pid and calls callback as soon as it exits. Watches a pidfd on
+    // the poller, so there is no SIGCHLD handler or periodic waitpid. pid
+    // must be a child of this process that nobody else waits for.
+    bool watch_child(pid_t pid, ExitCallback callback);
+
+    // Parent ends of a spawned child's stdio, already started on the loop.
+    // in takes send() and shutdown() to signal EOF; out and err are null
+    // when the child shares the parent's.
+    struct Child {
+        pid_t pid{-1};
+        std::shared_ptr<BasicConnection<Lock>> in;
+        std::shared_ptr<BasicConnection<Lock>> out;
+        std::shared_ptr<BasicConnection<Lock>> err;
+    };
+
+    // Starts argv[0], looked up in PATH, with stdin on a pipe and stdout
+    // and stderr on pipes feeding on_stdout and on_stderr, or inherited when
+    // those are null. The child gets an empty signal mask, whatever the
+    // loop blocks for its signalfd. on_exit may run before the last output
+    // has been read; the output connections close at EOF. pid is -1 on
+    // failure. Call from the loop thread or before run().
+    Child spawn(const std::vector<std::string>& argv, OutputCallback on_stdout,
+                OutputCallback on_stderr, ExitCallback on_exit);
+
+    // Runs work on the blocking pool, then done on this loop's thread. done
+    // comes back through post(), so completions that finish close together
+    // share one wakeup and are run in one pass. It runs even if work threw.
+    // Thread-safe; the loop waits for its outstanding work when destroyed.
+    bool submit_blocking(Task work, Task done = nullptr);
+
+    // Pool used by submit_blocking(), BlockingPool::shared() unless set.
+    // Set it before submitting anything.
+    void set_blocking_pool(BlockingPool& pool) { blocking_pool_ = &pool; }
+
+    BlockingPool& blocking_pool() {
+        return blocking_pool_ ? *blocking_pool_ : BlockingPool::shared();
+    }
+
+    // Coroutine frames started on the loop thread while run() is active are
+    // allocated from here, see coro.h.
+    FramePool& frame_pool() { return *frame_pool_; }
+
+private:
+    using TimePoint = typename BasicTimer<Lock>::TimePoint;
+
+    struct Hook {
+        int id;
+        Task callback;
+        bool removed;
+    };
+
+    MpscQueue<Task> tasks_;
+    std::vector<Task> deferred_;
+    // Swapped with deferred_ while it runs, so both keep their capacity.
+    std::vector<Task> running_deferred_;
+    std::vector<Hook> idle_hooks_;
+    std::vector<Hook> prepare_hooks_;
+    std::vector<Hook> check_hooks_;
+    int next_hook_id_{0};
+    bool running_hooks_{false};
+    int timer_fd_{-1};
+    TimePoint timer_fd_deadline_{};
+    LoopCounters counters_;
+    std::atomic<bool> stats_enabled_{false};
+    int stats_timer_id_{-1};
+    std::unique_ptr<LoopWatchdog> watchdog_;
+    std::unique_ptr<FramePool> frame_pool_;
+    int signal_fd_{-1};
+    sigset_t signal_mask_;
+    // Signals add_signal() blocked on its calling thread that were not
+    // blocked before.
+    sigset_t blocked_signals_;
+    std::unordered_map<int, SignalCallback> signal_handlers_;
+    BlockingPool* blocking_pool_{nullptr};
+    // Outstanding submit_blocking() work; the destructor waits on
+    // blocking_cv_ until it drops to zero.
+    std::atomic<size_t> blocking_inflight_{0};
+    std::mutex blocking_mtx;
+    std::condition_variable blocking_cv_;
+
+    void run_posted();
+
+    void run_deferred();
+
+    int add_hook(std::vector<Hook>& hooks, Task hook);
+
+    void run_hooks(std::vector<Hook>& hooks);
+
+    void invoke(Task& task, const char* what);
+
+    void create_timer_fd();
+
+    void handle_signals();
+
+    void unblock_signal(int signo);
+
+    std::chrono::nanoseconds precise_timeout(std::chrono::nanoseconds timeout);
 };
 
+// EvLoop may be used from any thread. LocalEvLoop has no locking at all and
+// must only be touched from the thread that runs it.
+using EvLoop = BasicEvLoop<ThreadSafe>;
+using LocalEvLoop = BasicEvLoop<NoLock>;
@@ -0,0 +1,173 @@
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <pthread.h>
+#include <sched.h>
+#include "evloop_group.h"
+//#define DEBUG
+
+#ifdef DEBUG
+#define dbg(a...) do { \
+    std::cerr << "[DEBUG] " << __FILE__ << ":" << __LINE__ << ":" << __FUNCTION__ <<" "; \
+    fprintf(stderr, a); \
+    std::cerr << std::endl; \
+} while(0)
+#else
+#define dbg(fmt, ...) do { } while(0)
+#endif
+
+template <typename Lock>
+BasicEvLoopGroup<Lock>::BasicEvLoopGroup(size_t count, BackendType backend, bool pin_cpus)
+    : load_(new LoadCounter[std::max<size_t>(count, 1)]), pin_cpus_(pin_cpus) {
+    count = std::max<size_t>(count, 1);
+    for (size_t i = 0; i < count; i++) {
+        loops_.push_back(std::make_unique<Loop>(backend));
+    }
+}
+
+template <typename Lock>
+BasicEvLoopGroup<Lock>::~BasicEvLoopGroup() {
+    stop();
+    join();
+    close_listeners();
+}
+
+template <typename Lock>
+bool BasicEvLoopGroup<Lock>::add_listener(size_t index, int port, int backlog, bool reuseport,
+                                          std::function<void(int fd)> on_accept) {
+    auto acceptor = std::make_unique<BasicAcceptor<Lock>>(*loops_[index]);
+    acceptor->set_budget(accept_budget_);
+    if (!acceptor->listen(port, std::move(on_accept), backlog, reuseport)) {
+        return false;
+    }
+    acceptors_.push_back(std::move(acceptor));
+    return true;
+}
+
+template <typename Lock>
+void BasicEvLoopGroup<Lock>::set_accept_budget(size_t budget) {
+    accept_budget_ = budget;
+    for (auto& acceptor : acceptors_) {
+        acceptor->set_budget(budget);
+    }
+}
+
+template <typename Lock>
+bool BasicEvLoopGroup<Lock>::listen_reuseport(int port, AcceptCallback callback, int backlog) {
+    if (started_ || !callback) {
+        return false;
+    }
+    for (size_t i = 0; i < loops_.size(); i++) {
+        auto on_accept = [this, i, callback](int fd) {
+            load_[i].value.fetch_add(1, std::memory_order_relaxed);
+            callback(i, fd);
+        };
+        if (!add_listener(i, port, backlog, true, on_accept)) {
+            close_listeners();
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename Lock>
+bool BasicEvLoopGroup<Lock>::listen_single(int port, AcceptCallback callback,
+                                           HandoffPolicy policy, int backlog) {
+    if (started_ || !callback) {
+        return false;
+    }
+    auto on_accept = [this, policy, callback](int fd) {
+        size_t index = pick(policy);
+        load_[index].value.fetch_add(1, std::memory_order_relaxed);
+        if (index == 0) {
+            callback(0, fd);
+        } else {
+            loops_[index]->post([callback, index, fd]() {
+                callback(index, fd);
+            });
+        }
+    };
+    return add_listener(0, port, backlog, false, on_accept);
+}
+
+template <typename Lock>
+size_t BasicEvLoopGroup<Lock>::pick(HandoffPolicy policy) {
+    if (policy == HandoffPolicy::ROUND_ROBIN) {
+        return next_.fetch_add(1, std::memory_order_relaxed) % loops_.size();
+    }
+
+    size_t best = 0;
+    long best_load = load_[0].value.load(std::memory_order_relaxed);
+    for (size_t i = 1; i < loops_.size(); i++) {
+        long value = load_[i].value.load(std::memory_order_relaxed);
+        if (value < best_load) {
+            best = i;
+            best_load = value;
+        }
+    }
+    return best;
+}
+
+template <typename Lock>
+void BasicEvLoopGroup<Lock>::release(size_t index) {
+    if (index < loops_.size()) {
+        load_[index].value.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+template <typename Lock>
+long BasicEvLoopGroup<Lock>::load(size_t index) const {
+    return index < loops_.size() ? load_[index].value.load(std::memory_order_relaxed) : 0;
+}
+
+template <typename Lock>
+bool BasicEvLoopGroup<Lock>::start(int default_timeout_ms) {
+    if (started_) {
+        return false;
+    }
+    started_ = true;
+
+    unsigned cpus = std::max(1u, std::thread::hardware_concurrency());
+    for (size_t i = 0; i < loops_.size(); i++) {
+        Loop* loop = loops_[i].get();
+        threads_.emplace_back([loop, default_timeout_ms]() {
+            loop->run(default_timeout_ms);
+        });
+
+        if (pin_cpus_) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(i % cpus, &set);
+            int rc = pthread_setaffinity_np(threads_.back().native_handle(), sizeof(set), &set);
+            if (rc != 0) {
+                std::cerr << "Failed to pin loop " << i << ": " << strerror(rc) << std::endl;
+            }
+        }
+    }
+    return true;
+}
+
+template <typename Lock>
+void BasicEvLoopGroup<Lock>::stop() {
+    for (auto& loop : loops_) {
+        loop->stop();
+    }
+}
+
+template <typename Lock>
+void BasicEvLoopGroup<Lock>::join() {
+    for (auto& thread : threads_) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+    threads_.clear();
+}
+
+template <typename Lock>
+void BasicEvLoopGroup<Lock>::close_listeners() {
+    acceptors_.clear();
+}
+
+template class BasicEvLoopGroup<ThreadSafe>;
+template class BasicEvLoopGroup<NoLock>;
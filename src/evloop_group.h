@@ -0,0 +1,83 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+#include "evloop.h"
+#include "acceptor.h"
+
+enum class HandoffPolicy {
+    ROUND_ROBIN,
+    LEAST_LOADED,
+};
+
+// Runs one loop per thread. Connections are either spread by the kernel
+// over per-loop SO_REUSEPORT listeners, or accepted on loop 0 and handed
+// off to the other loops.
+template <typename Lock>
+class BasicEvLoopGroup {
+public:
+    using Loop = BasicEvLoop<Lock>;
+    // Runs on the thread of the loop that owns the accepted fd.
+    using AcceptCallback = std::function<void(size_t index, int fd)>;
+
+    explicit BasicEvLoopGroup(size_t count, BackendType backend = BackendType::EPOLL,
+                              bool pin_cpus = false);
+    ~BasicEvLoopGroup();
+
+    BasicEvLoopGroup(const BasicEvLoopGroup&) = delete;
+    BasicEvLoopGroup& operator=(const BasicEvLoopGroup&) = delete;
+
+    // Listeners have to be set up before start().
+    bool listen_reuseport(int port, AcceptCallback callback, int backlog = SOMAXCONN);
+
+    bool listen_single(int port, AcceptCallback callback,
+                       HandoffPolicy policy = HandoffPolicy::ROUND_ROBIN,
+                       int backlog = SOMAXCONN);
+
+    // Connections each listener accepts per wakeup; see BasicAcceptor.
+    void set_accept_budget(size_t budget);
+
+    bool start(int default_timeout_ms = 1000);
+
+    // Safe to call from any thread; does not wait for the loops to exit.
+    void stop();
+
+    void join();
+
+    size_t size() const { return loops_.size(); }
+
+    Loop& loop(size_t index) { return *loops_[index]; }
+
+    size_t pick(HandoffPolicy policy);
+
+    // Load accounting used by LEAST_LOADED; call when a handed off
+    // connection goes away.
+    void release(size_t index);
+
+    long load(size_t index) const;
+
+private:
+    struct alignas(64) LoadCounter {
+        std::atomic<long> value{0};
+    };
+
+    std::vector<std::unique_ptr<Loop>> loops_;
+    std::vector<std::thread> threads_;
+    std::unique_ptr<LoadCounter[]> load_;
+    std::vector<std::unique_ptr<BasicAcceptor<Lock>>> acceptors_;
+    size_t accept_budget_{BasicAcceptor<Lock>::DEFAULT_BUDGET};
+    std::atomic<size_t> next_{0};
+    bool pin_cpus_;
+    bool started_{false};
+
+    bool add_listener(size_t index, int port, int backlog, bool reuseport,
+                      std::function<void(int fd)> on_accept);
+    void close_listeners();
+};
+
+using EvLoopGroup = BasicEvLoopGroup<ThreadSafe>;
+using LocalEvLoopGroup = BasicEvLoopGroup<NoLock>;
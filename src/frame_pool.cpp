@@ -0,0 +1,107 @@
+#include <iostream>
+#include <new>
+#include "frame_pool.h"
+//#define DEBUG
+
+#ifdef DEBUG
+#define dbg(a...) do { \
+    std::cerr << "[DEBUG] " << __FILE__ << ":" << __LINE__ << ":" << __FUNCTION__ <<" "; \
+    fprintf(stderr, a); \
+    std::cerr << std::endl; \
+} while(0)
+#else
+#define dbg(fmt, ...) do { } while(0)
+#endif
+
+static thread_local FramePool* current_pool = nullptr;
+
+FramePool::Scope::Scope(FramePool& pool) : previous_(current_pool) {
+    current_pool = &pool;
+}
+
+FramePool::Scope::~Scope() {
+    current_pool = previous_;
+}
+
+FramePool* FramePool::current() {
+    return current_pool;
+}
+
+FramePool::~FramePool() {
+    drain_remote();
+    for (Header*& head : free_) {
+        while (head) {
+            Header* next = head->next;
+            ::operator delete(head);
+            head = next;
+        }
+    }
+}
+
+void* FramePool::allocate(size_t size) {
+    size_t size_class = (size + GRANULE - 1) / GRANULE;
+    FramePool* pool = current_pool;
+    if (!pool || size_class == 0 || size_class > CLASSES) {
+        Header* header = static_cast<Header*>(::operator new(sizeof(Header) + size));
+        header->pool = nullptr;
+        header->size_class = 0;
+        return header + 1;
+    }
+    return pool->take(size_class - 1);
+}
+
+void FramePool::deallocate(void* ptr) noexcept {
+    if (!ptr) {
+        return;
+    }
+    Header* header = static_cast<Header*>(ptr) - 1;
+    FramePool* pool = header->pool;
+    if (!pool) {
+        ::operator delete(header);
+    } else if (pool == current_pool) {
+        pool->put(header);
+    } else {
+        Header* head = pool->remote_.load(std::memory_order_relaxed);
+        do {
+            header->next = head;
+        } while (!pool->remote_.compare_exchange_weak(head, header, std::memory_order_release,
+                                                      std::memory_order_relaxed));
+    }
+}
+
+void* FramePool::take(size_t size_class) {
+    if (!free_[size_class] && remote_.load(std::memory_order_relaxed)) {
+        drain_remote();
+    }
+    Header* header = free_[size_class];
+    if (header) {
+        free_[size_class] = header->next;
+        cached_[size_class]--;
+        reused_++;
+    } else {
+        header = static_cast<Header*>(::operator new(sizeof(Header) + (size_class + 1) * GRANULE));
+        header->pool = this;
+        header->size_class = size_class;
+    }
+    return header + 1;
+}
+
+void FramePool::put(Header* header) {
+    size_t size_class = header->size_class;
+    if (cached_[size_class] >= MAX_CACHED) {
+        ::operator delete(header);
+        return;
+    }
+    header->next = free_[size_class];
+    free_[size_class] = header;
+    cached_[size_class]++;
+}
+
+void FramePool::drain_remote() {
+    Header* header = remote_.exchange(nullptr, std::memory_order_acquire);
+    while (header) {
+        Header* next = header->next;
+        put(header);
+        header = next;
+    }
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Free-list allocator for coroutine frames, one per loop. Frames are
+// rounded up to GRANULE-byte classes; bigger ones go to operator new. The
+// pool installed on the calling thread with Scope serves allocations, and
+// a frame freed on another thread (a coroutine that moved to another loop)
+// is handed back through a lock-free list the owner drains on its next
+// allocation. The pool must outlive every frame it handed out.
+class FramePool {
+public:
+    static constexpr size_t GRANULE = 64;
+    static constexpr size_t MAX_POOLED = 4096;
+    // Free frames kept per class; the rest are released.
+    static constexpr size_t MAX_CACHED = 256;
+
+    FramePool() = default;
+    ~FramePool();
+
+    FramePool(const FramePool&) = delete;
+    FramePool& operator=(const FramePool&) = delete;
+
+    // Makes a pool the calling thread's current one for its lifetime.
+    class Scope {
+    public:
+        explicit Scope(FramePool& pool);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        FramePool* previous_;
+    };
+
+    // Served from the current pool, or operator new when there is none.
+    static void* allocate(size_t size);
+
+    static void deallocate(void* ptr) noexcept;
+
+    static FramePool* current();
+
+    // Frames allocated without touching operator new.
+    uint64_t reused() const { return reused_; }
+
+private:
+    static constexpr size_t CLASSES = MAX_POOLED / GRANULE;
+
+    struct alignas(16) Header {
+        FramePool* pool;
+        size_t size_class;
+        Header* next;
+    };
+
+    std::array<Header*, CLASSES> free_{};
+    std::array<size_t, CLASSES> cached_{};
+    std::atomic<Header*> remote_{nullptr};
+    uint64_t reused_{0};
+
+    void* take(size_t size_class);
+
+    void put(Header* header);
+
+    void drain_remote();
+};
@@ -0,0 +1,50 @@
+#include <sstream>
+#include "loop_stats.h"
+
+LoopStats LoopCounters::snapshot() const {
+    LoopStats stats;
+    stats.iterations = iterations_.load(std::memory_order_relaxed);
+    stats.poll_ns = poll_ns_.load(std::memory_order_relaxed);
+    stats.callback_ns = callback_ns_.load(std::memory_order_relaxed);
+    stats.callbacks = callbacks_.load(std::memory_order_relaxed);
+    stats.wakeup_writes = wakeup_writes_.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < LoopStats::READY_BUCKETS; i++) {
+        stats.ready_fds[i] = ready_fds_[i].load(std::memory_order_relaxed);
+    }
+    for (size_t i = 0; i < LoopStats::LATENESS_BUCKETS; i++) {
+        stats.timer_lateness_us[i] = lateness_us_[i].load(std::memory_order_relaxed);
+    }
+    stats.slowest_callback_ns = slowest_ns_.load(std::memory_order_relaxed);
+    stats.slowest_fd = slowest_fd_.load(std::memory_order_relaxed);
+    stats.slowest_timer_id = slowest_timer_id_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void write_histogram(std::ostream& out, const uint64_t* buckets, size_t count) {
+    size_t used = count;
+    while (used > 0 && buckets[used - 1] == 0) {
+        used--;
+    }
+    out << "[";
+    for (size_t i = 0; i < used; i++) {
+        out << (i ? "," : "") << buckets[i];
+    }
+    out << "]";
+}
+
+std::string LoopStats::to_json() const {
+    std::ostringstream out;
+    out << "{\"iterations\":" << iterations
+        << ",\"poll_ns\":" << poll_ns
+        << ",\"callback_ns\":" << callback_ns
+        << ",\"callbacks\":" << callbacks
+        << ",\"wakeup_writes\":" << wakeup_writes
+        << ",\"ready_fds\":";
+    write_histogram(out, ready_fds, READY_BUCKETS);
+    out << ",\"timer_lateness_us\":";
+    write_histogram(out, timer_lateness_us, LATENESS_BUCKETS);
+    out << ",\"slowest_callback_ns\":" << slowest_callback_ns
+        << ",\"slowest_fd\":" << slowest_fd
+        << ",\"slowest_timer_id\":" << slowest_timer_id << "}";
+    return out.str();
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+// Snapshot of a loop's counters. Histogram bucket i counts values of bit
+// width i: bucket 0 holds zeros and bucket i covers [2^(i-1), 2^i).
+struct LoopStats {
+    static constexpr size_t READY_BUCKETS = 16;
+    static constexpr size_t LATENESS_BUCKETS = 32;
+
+    uint64_t iterations{0};
+    uint64_t poll_ns{0};
+    uint64_t callback_ns{0};
+    uint64_t callbacks{0};
+    uint64_t wakeup_writes{0};
+    // Ready fds plus completions per wakeup.
+    uint64_t ready_fds[READY_BUCKETS]{};
+    // Timer fire time minus its deadline, in microseconds.
+    uint64_t timer_lateness_us[LATENESS_BUCKETS]{};
+    uint64_t slowest_callback_ns{0};
+    int slowest_fd{-1};
+    int slowest_timer_id{-1};
+
+    std::string to_json() const;
+};
+
+// Writes buckets as a JSON array, leaving out the empty tail.
+void write_histogram(std::ostream& out, const uint64_t* buckets, size_t count);
+
+// Written by the loop thread only (wakeup writes excepted), so updates are
+// plain relaxed load/store pairs. snapshot() may run on any thread.
+class LoopCounters {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    void record_wait(Clock::duration blocked, size_t ready) {
+        bump(poll_ns_, to_ns(blocked));
+        bump(ready_fds_[std::min(bucket(ready), LoopStats::READY_BUCKETS - 1)], 1);
+    }
+
+    void record_callback(Clock::duration spent, int fd, int timer_id) {
+        uint64_t ns = to_ns(spent);
+        bump(callback_ns_, ns);
+        bump(callbacks_, 1);
+        if (ns > slowest_ns_.load(std::memory_order_relaxed)) {
+            slowest_ns_.store(ns, std::memory_order_relaxed);
+            slowest_fd_.store(fd, std::memory_order_relaxed);
+            slowest_timer_id_.store(timer_id, std::memory_order_relaxed);
+        }
+    }
+
+    void record_lateness(Clock::duration late) {
+        uint64_t us = to_ns(late) / 1000;
+        bump(lateness_us_[std::min(bucket(us), LoopStats::LATENESS_BUCKETS - 1)], 1);
+    }
+
+    void record_iteration() {
+        bump(iterations_, 1);
+    }
+
+    // May be called from any thread.
+    void record_wakeup_write() {
+        wakeup_writes_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // What the loop is doing right now, for the stall watchdog. busy_since
+    // is zero while the loop is blocked in its wait.
+    void set_busy(Clock::time_point since) {
+        busy_since_ns_.store(to_ns(since.time_since_epoch()), std::memory_order_relaxed);
+    }
+
+    void set_idle() {
+        busy_since_ns_.store(0, std::memory_order_relaxed);
+    }
+
+    void set_current(int fd, int timer_id) {
+        current_fd_.store(fd, std::memory_order_relaxed);
+        current_timer_id_.store(timer_id, std::memory_order_relaxed);
+    }
+
+    uint64_t busy_since_ns() const { return busy_since_ns_.load(std::memory_order_relaxed); }
+
+    int current_fd() const { return current_fd_.load(std::memory_order_relaxed); }
+
+    int current_timer_id() const { return current_timer_id_.load(std::memory_order_relaxed); }
+
+    LoopStats snapshot() const;
+
+private:
+    static void bump(std::atomic<uint64_t>& counter, uint64_t value) {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    static size_t bucket(uint64_t value) {
+        return value == 0 ? 0 : 64 - __builtin_clzll(value);
+    }
+
+    static uint64_t to_ns(Clock::duration d) {
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(d).count();
+        return ns > 0 ? static_cast<uint64_t>(ns) : 0;
+    }
+
+    std::atomic<uint64_t> iterations_{0};
+    std::atomic<uint64_t> poll_ns_{0};
+    std::atomic<uint64_t> callback_ns_{0};
+    std::atomic<uint64_t> callbacks_{0};
+    std::atomic<uint64_t> ready_fds_[LoopStats::READY_BUCKETS]{};
+    std::atomic<uint64_t> lateness_us_[LoopStats::LATENESS_BUCKETS]{};
+    std::atomic<uint64_t> slowest_ns_{0};
+    std::atomic<int> slowest_fd_{-1};
+    std::atomic<int> slowest_timer_id_{-1};
+    std::atomic<uint64_t> busy_since_ns_{0};
+    std::atomic<int> current_fd_{-1};
+    std::atomic<int> current_timer_id_{-1};
+    alignas(64) std::atomic<uint64_t> wakeup_writes_{0};
+};
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <atomic>
+#include <utility>
+
+// Lock-free multi-producer single-consumer queue (Vyukov). push() and
+// push_batch() may be called from any thread, everything else only from
+// the consumer.
+template <typename T>
+class MpscQueue {
+public:
+    MpscQueue() {
+        Node* stub = new Node();
+        head_.store(stub, std::memory_order_relaxed);
+        tail_ = stub;
+    }
+
+    ~MpscQueue() {
+        Node* node = tail_;
+        while (node) {
+            Node* next = node->next.load(std::memory_order_relaxed);
+            delete node;
+            node = next;
+        }
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    void push(T value) {
+        Node* node = new Node(std::move(value));
+        link(node, node);
+    }
+
+    // Publishes all values with a single atomic exchange.
+    template <typename It>
+    size_t push_batch(It begin, It end) {
+        Node* first = nullptr;
+        Node* last = nullptr;
+        size_t count = 0;
+        for (; begin != end; ++begin, ++count) {
+            Node* node = new Node(std::move(*begin));
+            if (last) {
+                last->next.store(node, std::memory_order_relaxed);
+            } else {
+                first = node;
+            }
+            last = node;
+        }
+        if (first) {
+            link(first, last);
+        }
+        return count;
+    }
+
+    bool empty() const {
+        return tail_->next.load(std::memory_order_acquire) == nullptr;
+    }
+
+    // Runs fn on every value that was queued when consume() started.
+    // Values pushed by fn itself are left for the next call.
+    template <typename F>
+    size_t consume(F&& fn) {
+        Node* end = head_.load(std::memory_order_acquire);
+        size_t count = 0;
+        while (tail_ != end) {
+            Node* next = tail_->next.load(std::memory_order_acquire);
+            if (!next) {
+                break;
+            }
+            delete tail_;
+            tail_ = next;
+            T value = std::move(next->value);
+            count++;
+            fn(value);
+        }
+        return count;
+    }
+
+private:
+    struct Node {
+        std::atomic<Node*> next{nullptr};
+        T value;
+        Node() {}
+        explicit Node(T v): value(std::move(v)) {}
+    };
+
+    void link(Node* first, Node* last) {
+        Node* prev = head_.exchange(last, std::memory_order_acq_rel);
+        prev->next.store(first, std::memory_order_release);
+    }
+
+    alignas(64) std::atomic<Node*> head_;
+    alignas(64) Node* tail_;
+};
@@ -5,6 +5,9 @@
 #include <cerrno>
 #include <fcntl.h>
 #include <unistd.h>
+#include <sys/socket.h>
+#include <sys/eventfd.h>
+#include <sys/sendfile.h>
 #include "poller.h"
 //#define DEBUG
 
@@ -18,153 +21,469 @@
 #define dbg(fmt, ...) do { } while(0)
 #endif
 
-void Poller::close_pipe() {
-    if (pipe_fds[0] > 0) {
-        remove(pipe_fds[0]);
-        close(pipe_fds[0]);
-        close(pipe_fds[1]);
-        pipe_fds[0] = pipe_fds[1] = -1;
+template <typename Lock>
+void BasicPoller<Lock>::close_wakeup() {
+    if (wake_fd_ >= 0) {
+        remove(wake_fd_);
+        close(wake_fd_);
+        wake_fd_ = -1;
     }
 }
 
-Poller::Poller() {
-    pipe_fds[0] = pipe_fds[1] = -1;
-    create_pipe();
+template <typename Lock>
+BasicPoller<Lock>::BasicPoller(BackendType backend): backend_(PollerBackend::create(backend)) {
+    create_wakeup();
 }
 
-Poller::~Poller() {
+template <typename Lock>
+BasicPoller<Lock>::~BasicPoller() {
     stop();
-    close_pipe();
+    close_wakeup();
 }
 
-void Poller::start() {
+template <typename Lock>
+void BasicPoller<Lock>::start() {
     running_ = true;
 }
 
-bool Poller::add(int fd, short events, FdCallback callback) {
-    std::unique_lock<std::shared_mutex> lock(mtx);
+template <typename Lock>
+typename BasicPoller<Lock>::FdSlot* BasicPoller<Lock>::find_slot(int fd) {
+    size_t chunk = static_cast<size_t>(fd) >> FD_CHUNK_BITS;
+    if (fd < 0 || chunk >= fd_table_.size() || !fd_table_[chunk]) {
+        return nullptr;
+    }
+    return &(*fd_table_[chunk])[fd & FD_CHUNK_MASK];
+}
+
+template <typename Lock>
+typename BasicPoller<Lock>::FdSlot& BasicPoller<Lock>::grow_slot(int fd) {
+    size_t chunk = static_cast<size_t>(fd) >> FD_CHUNK_BITS;
+    if (chunk >= fd_table_.size()) {
+        fd_table_.resize(chunk + 1);
+    }
+    if (!fd_table_[chunk]) {
+        fd_table_[chunk] = std::make_unique<FdChunk>();
+    }
+    return (*fd_table_[chunk])[fd & FD_CHUNK_MASK];
+}
+
+template <typename Lock>
+bool BasicPoller<Lock>::add(int fd, short events, FdCallback callback, unsigned mode) {
+    std::unique_lock<Mutex> lock(mtx);
     if (fd < 0 || !callback) {
         return false;
     }
 
-    if (fd_map_.find(fd) != fd_map_.end()) {
+    FdSlot* slot = find_slot(fd);
+    if (slot && slot->active) {
         dbg("Warning: FD %d is already being watched", fd);
         return false;
     }
-    fd_map_[fd] = std::make_unique<FdInfo>(std::move(callback), events);
+    if (!backend_->add(fd, events, mode)) {
+        return false;
+    }
+    if (!slot) {
+        slot = &grow_slot(fd);
+    }
+    slot->callback = std::move(callback);
+    slot->events = events;
+    slot->mode = mode;
+    slot->gen++;
+    slot->active = true;
+    fd_count_++;
     return true;
 }
 
-bool Poller::remove(int fd) {
-    std::unique_lock<std::shared_mutex> lock(mtx);
-    auto it = fd_map_.find(fd);
-    if (it == fd_map_.end()) {
+template <typename Lock>
+bool BasicPoller<Lock>::remove(int fd) {
+    std::unique_lock<Mutex> lock(mtx);
+    FdSlot* slot = find_slot(fd);
+    if (!slot || !slot->active) {
         return false;
     }
-    it->second->active = false;
+    slot->active = false;
+    slot->callback = nullptr;
+    fd_count_--;
+    backend_->remove(fd);
     return true;
 }
 
-bool Poller::update_events(int fd, short events) {
-    std::unique_lock<std::shared_mutex> lock(mtx);
-    auto it = fd_map_.find(fd);
-    if (it == fd_map_.end()) {
+template <typename Lock>
+bool BasicPoller<Lock>::update_events(int fd, short events) {
+    std::unique_lock<Mutex> lock(mtx);
+    FdSlot* slot = find_slot(fd);
+    if (!slot || !slot->active) {
         return false;
     }
-    it->second->events = events;
+    if (!backend_->modify(fd, events, slot->mode)) {
+        return false;
+    }
+    slot->events = events;
     dbg("updated events fd %d, %04x", fd, events);
     return true;
 }
 
-bool Poller::create_pipe() {
-
-    if (pipe(pipe_fds) != 0) {
-        dbg("Failed to create pipe: %s", strerror(errno).c_str());
+template <typename Lock>
+bool BasicPoller<Lock>::rearm(int fd) {
+    std::unique_lock<Mutex> lock(mtx);
+    FdSlot* slot = find_slot(fd);
+    if (!slot || !slot->active || !(slot->mode & POLL_ONESHOT)) {
         return false;
     }
+    return backend_->modify(fd, slot->events, slot->mode);
+}
 
-    int flags = fcntl(pipe_fds[0], F_GETFL);
-    if (flags == -1 || fcntl(pipe_fds[0], F_SETFL, flags | O_NONBLOCK) == -1) {
-        std::cerr << "Failed to set pipe non-blocking: " << strerror(errno) << std::endl;
-        close(pipe_fds[0]);
-        close(pipe_fds[1]);
-        pipe_fds[0] = pipe_fds[1] = -1;
+template <typename Lock>
+bool BasicPoller<Lock>::async_read(int fd, void* buf, size_t len, IoCallback callback) {
+    return submit_op(AsyncOpType::READ, fd, buf, len, std::move(callback));
+}
+
+template <typename Lock>
+bool BasicPoller<Lock>::async_write(int fd, const void* buf, size_t len, IoCallback callback) {
+    return submit_op(AsyncOpType::WRITE, fd, const_cast<void*>(buf), len, std::move(callback));
+}
+
+template <typename Lock>
+bool BasicPoller<Lock>::async_accept(int fd, IoCallback callback) {
+    return submit_op(AsyncOpType::ACCEPT, fd, nullptr, 0, std::move(callback));
+}
+
+template <typename Lock>
+bool BasicPoller<Lock>::submit_op(AsyncOpType type, int fd, void* buf, size_t len, IoCallback callback) {
+    if (fd < 0 || !callback) {
         return false;
     }
 
-    flags = fcntl(pipe_fds[1], F_GETFL);
-    if (flags == -1 || fcntl(pipe_fds[1], F_SETFL, flags | O_NONBLOCK) == -1) {
-        std::cerr << "Failed to set pipe write end non-blocking: " << strerror(errno) << std::endl;
-        close(pipe_fds[0]);
-        close(pipe_fds[1]);
-        pipe_fds[0] = pipe_fds[1] = -1;
+    std::unique_lock<Mutex> lock(mtx);
+    uint64_t token = next_op_token_++;
+    if (backend_->submit({type, fd, buf, len, token})) {
+        op_map_[token] = {fd, std::move(callback)};
+        return true;
+    }
+    lock.unlock();
+
+    auto handler = [this, type, buf, len, cb = std::move(callback)](int fd, short events, short revents) {
+        (void)events;
+        (void)revents;
+        ssize_t result;
+        switch (type) {
+        case AsyncOpType::READ:
+            result = ::read(fd, buf, len);
+            break;
+        case AsyncOpType::WRITE:
+            result = ::write(fd, buf, len);
+            break;
+        default:
+            result = ::accept4(fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            break;
+        }
+        if (result < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+                return;
+            }
+            result = -errno;
+        }
+        remove(fd);
+        cb(fd, static_cast<int>(result));
+    };
+
+    return add(fd, type == AsyncOpType::WRITE ? POLLOUT : POLLIN, std::move(handler));
+}
+
+template <typename Lock>
+bool BasicPoller<Lock>::create_wakeup() {
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wake_fd_ < 0) {
+        std::cerr << "Failed to create eventfd: " << strerror(errno) << std::endl;
         return false;
     }
 
     auto callback = [this](int fd, short events, short revents) {
-        handle_pipe_callback(fd, events, revents);
+        handle_wakeup(fd, events, revents);
     };
 
-    if (!add(pipe_fds[0], POLLIN, callback)) {
-        std::cerr << "Failed to add pipe to event loop" << std::endl;
-        close(pipe_fds[0]);
-        close(pipe_fds[1]);
-        pipe_fds[0] = pipe_fds[1] = -1;
+    if (!add(wake_fd_, POLLIN, callback)) {
+        std::cerr << "Failed to add eventfd to event loop" << std::endl;
+        close(wake_fd_);
+        wake_fd_ = -1;
         return false;
     }
 
     return true;
 }
 
-void Poller::handle_pipe_callback(int fd, short events, short revents) {
+template <typename Lock>
+void BasicPoller<Lock>::handle_wakeup(int fd, short events, short revents) {
 
     (void)events;
 
     if (revents & POLLIN) {
-        char buffer[256];
-        ssize_t bytes_read;
-        do {
-            bytes_read = read(fd, buffer, sizeof(buffer));
-        } while (bytes_read > 0);
+        uint64_t value;
+        if (read(fd, &value, sizeof(value)) < 0) {
+            dbg("Failed to read eventfd: %s", strerror(errno));
+        }
+        wake_pending_.store(false);
     }
+}
 
-    if (revents & (POLLERR | POLLHUP | POLLNVAL)) {
+// A wakeup is only needed when another thread may be blocked in poll().
+// Calls from the loop thread are picked up before the next wait, and a
+// pending wakeup that the loop has not consumed yet covers later calls.
+template <typename Lock>
+void BasicPoller<Lock>::trigger_loop() const {
+    if (wake_fd_ < 0) {
+        return;
+    }
+    if (loop_thread_.load(std::memory_order_relaxed) == std::this_thread::get_id()) {
+        return;
+    }
+    if (wake_pending_.exchange(true)) {
+        return;
+    }
+
+    uint64_t one = 1;
+    if (write(wake_fd_, &one, sizeof(one)) != sizeof(one)) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            std::cerr << "Failed to write to eventfd: " << strerror(errno) << std::endl;
+        }
+    }
+    if (LoopCounters* stats = stats_.load(std::memory_order_relaxed)) {
+        stats->record_wakeup_write();
     }
 }
 
-void Poller::trigger_loop() const {
-    if (pipe_fds[1] > -1) {
-        char wake_byte = 1;
-        ssize_t result = write(pipe_fds[1], &wake_byte, 1);
+template <typename Lock>
+bool BasicPoller<Lock>::send_file(int fd, int file_fd, off_t offset, size_t len,
+                                  TransferCallback callback) {
+    if (fd < 0 || file_fd < 0 || !callback) {
+        return false;
+    }
 
-        if (result != 1) {
-            if (errno != EAGAIN && errno != EWOULDBLOCK) {
-                std::cerr << "Failed to write to pipe: " << strerror(errno) << std::endl;
+    size_t remaining = len ? len : SIZE_MAX;
+    int64_t sent = 0;
+    auto handler = [this, file_fd, offset, remaining, sent, cb = std::move(callback)]
+                   (int fd, short events, short revents) mutable {
+        (void)events;
+        int64_t result = 0;
+        bool finished = false;
+        if (revents & (POLLERR | POLLHUP | POLLNVAL)) {
+            result = (revents & POLLNVAL) ? -EBADF : -EPIPE;
+            finished = true;
+        }
+        while (!finished) {
+            ssize_t n = sendfile(fd, file_fd, &offset, std::min<size_t>(remaining, 1 << 30));
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    return;
+                }
+                result = -errno;
+                finished = true;
+            } else {
+                sent += n;
+                remaining -= n;
+                // A zero return is the end of the file.
+                finished = n == 0 || remaining == 0;
+                result = sent;
             }
         }
+        remove(fd);
+        cb(fd, result);
+    };
+
+    return add(fd, POLLOUT, std::move(handler));
+}
+
+// Bytes sit in the pipe between the two splices. in_fd is only polled while
+// the pipe has room and out_fd only while it holds data.
+template <typename Lock>
+struct BasicPoller<Lock>::SpliceState {
+    int in_fd;
+    int out_fd;
+    int pipe_fds[2]{-1, -1};
+    size_t capacity{0};
+    size_t buffered{0};
+    int64_t total{0};
+    short in_events{POLLIN};
+    short out_events{0};
+    bool eof{false};
+    bool finished{false};
+    TransferCallback callback;
+};
+
+template <typename Lock>
+bool BasicPoller<Lock>::splice_forward(int in_fd, int out_fd, TransferCallback callback) {
+    if (in_fd < 0 || out_fd < 0 || in_fd == out_fd || !callback) {
+        return false;
     }
+
+    auto state = std::make_shared<SpliceState>();
+    state->in_fd = in_fd;
+    state->out_fd = out_fd;
+    state->callback = std::move(callback);
+    if (pipe2(state->pipe_fds, O_NONBLOCK | O_CLOEXEC) < 0) {
+        std::cerr << "Failed to create splice pipe: " << strerror(errno) << std::endl;
+        return false;
+    }
+    // A larger pipe means fewer wakeups per byte; the default still works.
+    fcntl(state->pipe_fds[1], F_SETPIPE_SZ, 1 << 20);
+    int capacity = fcntl(state->pipe_fds[1], F_GETPIPE_SZ);
+    state->capacity = capacity > 0 ? capacity : 65536;
+
+    auto on_in = [this, state](int fd, short events, short revents) {
+        (void)fd;
+        (void)events;
+        if (revents & POLLNVAL) {
+            splice_finish(state, -EBADF);
+            return;
+        }
+        splice_in(state);
+    };
+    auto on_out = [this, state](int fd, short events, short revents) {
+        (void)fd;
+        (void)events;
+        if (revents & (POLLERR | POLLHUP | POLLNVAL)) {
+            splice_finish(state, (revents & POLLNVAL) ? -EBADF : -EPIPE);
+            return;
+        }
+        splice_out(state);
+    };
+
+    if (!add(in_fd, POLLIN, std::move(on_in))) {
+        close(state->pipe_fds[0]);
+        close(state->pipe_fds[1]);
+        return false;
+    }
+    if (!add(out_fd, 0, std::move(on_out))) {
+        remove(in_fd);
+        close(state->pipe_fds[0]);
+        close(state->pipe_fds[1]);
+        return false;
+    }
+    return true;
 }
 
-int Poller::poll(int timeout_ms) {
-    std::vector<pollfd> poll_fds_;
-    std::shared_lock<std::shared_mutex> lock(mtx);
-    poll_fds_.reserve(fd_map_.size());
+template <typename Lock>
+void BasicPoller<Lock>::splice_in(const std::shared_ptr<SpliceState>& state) {
+    while (!state->finished && state->buffered < state->capacity) {
+        ssize_t n = splice(state->in_fd, nullptr, state->pipe_fds[1], nullptr,
+                           state->capacity - state->buffered, SPLICE_F_NONBLOCK | SPLICE_F_MOVE);
+        if (n > 0) {
+            state->buffered += n;
+            continue;
+        }
+        if (n == 0) {
+            state->eof = true;
+        } else if (errno == EINTR) {
+            continue;
+        } else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            splice_finish(state, -errno);
+            return;
+        }
+        break;
+    }
 
-    for (const auto& pair : fd_map_) {
-        if (pair.second->active) {
-            poll_fds_.push_back({
-                .fd = pair.first,
-                .events = pair.second->events,
-                .revents = 0
-            });
+    // Push the data on right away; out_fd is usually writable.
+    if (state->buffered > 0 || state->eof) {
+        splice_out(state);
+    }
+    if (state->finished) {
+        return;
+    }
+    short in_events = (state->eof || state->buffered >= state->capacity) ? 0 : POLLIN;
+    if (in_events != state->in_events) {
+        state->in_events = in_events;
+        update_events(state->in_fd, in_events);
+    }
+}
+
+template <typename Lock>
+void BasicPoller<Lock>::splice_out(const std::shared_ptr<SpliceState>& state) {
+    while (!state->finished && state->buffered > 0) {
+        ssize_t n = splice(state->pipe_fds[0], nullptr, state->out_fd, nullptr,
+                           state->buffered, SPLICE_F_NONBLOCK | SPLICE_F_MOVE);
+        if (n > 0) {
+            state->buffered -= n;
+            state->total += n;
+            continue;
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+            splice_finish(state, -errno);
+            return;
         }
+        break;
+    }
+    if (state->finished) {
+        return;
+    }
+    if (state->buffered == 0 && state->eof) {
+        splice_finish(state, state->total);
+        return;
+    }
+
+    short out_events = state->buffered > 0 ? POLLOUT : 0;
+    if (out_events != state->out_events) {
+        state->out_events = out_events;
+        update_events(state->out_fd, out_events);
+    }
+    if (!state->eof && state->in_events == 0 && state->buffered < state->capacity) {
+        state->in_events = POLLIN;
+        update_events(state->in_fd, POLLIN);
+    }
+}
+
+template <typename Lock>
+void BasicPoller<Lock>::splice_finish(const std::shared_ptr<SpliceState>& state, int64_t result) {
+    if (state->finished) {
+        return;
     }
+    state->finished = true;
+    remove(state->in_fd);
+    remove(state->out_fd);
+    close(state->pipe_fds[0]);
+    close(state->pipe_fds[1]);
+    TransferCallback callback = std::move(state->callback);
+    callback(state->in_fd, result);
+}
 
-    if (poll_fds_.empty()) {
+template <typename Lock>
+int BasicPoller<Lock>::poll(int timeout_ms) {
+    if (timeout_ms < 0) {
+        return poll(std::chrono::nanoseconds(-1));
+    }
+    return poll(std::chrono::milliseconds(timeout_ms));
+}
+
+template <typename Lock>
+int BasicPoller<Lock>::poll(std::chrono::nanoseconds timeout) {
+    auto self = std::this_thread::get_id();
+    if (loop_thread_.load(std::memory_order_relaxed) != self) {
+        loop_thread_.store(self, std::memory_order_relaxed);
+    }
+    std::shared_lock<Mutex> lock(mtx);
+    if (fd_count_ == 0) {
         return -1;
     }
+    backend_->prepare();
     lock.unlock();
-    int result = ::poll(poll_fds_.data(), poll_fds_.size(), timeout_ms);
+    LoopCounters* stats = stats_.load(std::memory_order_relaxed);
+    LoopCounters::Clock::time_point start;
+    if (stats) {
+        start = LoopCounters::Clock::now();
+        stats->set_idle();
+    }
+    int result = backend_->wait(timeout);
+    LoopCounters::Clock::duration blocked{};
+    if (stats) {
+        auto woke = LoopCounters::Clock::now();
+        stats->set_busy(woke);
+        blocked = woke - start;
+    }
     lock.lock();
     if (result < 0) {
         if (errno == EINTR)
@@ -172,45 +491,88 @@ int Poller::poll(int timeout_ms) {
         perror("poll");
         return -1;
     }
+    backend_->collect(ready_, done_);
+    if (stats) {
+        stats->record_wait(blocked, ready_.size() + done_.size());
+    }
 
-    processing_loop_ = true;
-
-    for (const auto& pfd : poll_fds_) {
-        if (pfd.revents != 0) {
-            auto it = fd_map_.find(pfd.fd);
-            if (it != fd_map_.end() && it->second->active) {
-                lock.unlock();
-                try {
-                    it->second->callback(pfd.fd, pfd.events, pfd.revents);
-                } catch (const std::exception& e) {
-                    std::cerr << "Exception in fd callback for fd " << pfd.fd
-                        << ": " << e.what() << std::endl;
-                } catch (...) {
-                    std::cerr << "Unknown exception in fd callback for fd " << pfd.fd << std::endl;
-                }
-                lock.lock();
-            }
+    ready_gen_.resize(ready_.size());
+    for (size_t i = 0; i < ready_.size(); i++) {
+        FdSlot* slot = find_slot(ready_[i].fd);
+        ready_gen_[i] = slot ? slot->gen : 0;
+    }
+
+    // The handler is moved out of its slot while it runs, so it may remove
+    // or re-add its own fd (or another thread may) without destroying the
+    // callable under our feet.
+    for (size_t i = 0; i < ready_.size(); i++) {
+        const pollfd& pfd = ready_[i];
+        if (pfd.revents == 0) {
+            continue;
+        }
+        FdSlot* slot = find_slot(pfd.fd);
+        if (!slot || !slot->active || slot->gen != ready_gen_[i]) {
+            continue;
+        }
+        short events = slot->events;
+        FdCallback callback = std::move(slot->callback);
+        lock.unlock();
+        if (stats) {
+            start = LoopCounters::Clock::now();
+            stats->set_current(pfd.fd, -1);
+        }
+        try {
+            callback(pfd.fd, events, pfd.revents);
+        } catch (const std::exception& e) {
+            std::cerr << "Exception in fd callback for fd " << pfd.fd
+                << ": " << e.what() << std::endl;
+        } catch (...) {
+            std::cerr << "Unknown exception in fd callback for fd " << pfd.fd << std::endl;
+        }
+        if (stats) {
+            stats->record_callback(LoopCounters::Clock::now() - start, pfd.fd, -1);
+            stats->set_current(-1, -1);
+        }
+        lock.lock();
+        if (slot->active && slot->gen == ready_gen_[i] && !slot->callback) {
+            slot->callback = std::move(callback);
         }
     }
 
-    processing_loop_ = false;
-    lock.unlock();
-    {
-        std::unique_lock<std::shared_mutex> wlock(mtx);
-        for (auto it = fd_map_.begin(); it != fd_map_.end();) {
-            if (!it->second->active) {
-                it = fd_map_.erase(it);
-            } else {
-                ++it;
-            }
+    for (const auto& done : done_) {
+        auto it = op_map_.find(done.token);
+        if (it == op_map_.end()) {
+            continue;
+        }
+        OpInfo op = std::move(it->second);
+        op_map_.erase(it);
+        lock.unlock();
+        if (stats) {
+            start = LoopCounters::Clock::now();
+            stats->set_current(op.fd, -1);
+        }
+        try {
+            op.callback(op.fd, done.res);
+        } catch (const std::exception& e) {
+            std::cerr << "Exception in io callback for fd " << op.fd
+                << ": " << e.what() << std::endl;
+        } catch (...) {
+            std::cerr << "Unknown exception in io callback for fd " << op.fd << std::endl;
         }
+        if (stats) {
+            stats->record_callback(LoopCounters::Clock::now() - start, op.fd, -1);
+            stats->set_current(-1, -1);
+        }
+        lock.lock();
     }
 
     return result;
 }
 
-void Poller::run(int default_timeout_ms) {
+template <typename Lock>
+void BasicPoller<Lock>::run(int default_timeout_ms) {
     running_ = true;
+    set_owner_thread(std::this_thread::get_id());
 
     while (running_) {
         int result = poll(default_timeout_ms);
@@ -219,20 +581,31 @@ void Poller::run(int default_timeout_ms) {
             break;
         }
     }
+    set_owner_thread(std::thread::id());
 }
 
-void Poller::stop() {
+template <typename Lock>
+void BasicPoller<Lock>::stop() {
     running_ = false;
     trigger_loop();
 }
 
-bool Poller::is_running() const {
+template <typename Lock>
+bool BasicPoller<Lock>::is_running() const {
     return running_.load();
 
 }
 
-size_t Poller::get_fd_count() const {
-    std::shared_lock<std::shared_mutex> lock(mtx);
-    return fd_map_.size();
+template <typename Lock>
+size_t BasicPoller<Lock>::get_fd_count() const {
+    std::shared_lock<Mutex> lock(mtx);
+    return fd_count_;
+}
+
+template <typename Lock>
+void BasicPoller<Lock>::set_owner_thread(std::thread::id owner) {
+    Lock::bind(mtx, owner);
 }
 
+template class BasicPoller<ThreadSafe>;
+template class BasicPoller<NoLock>;
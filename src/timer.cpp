@@ -18,160 +18,550 @@
 #define dbg(fmt, ...) do { } while(0)
 #endif
 
-Timer::Timer(): next_timer_id_(1) {
+template <typename Lock>
+BasicTimer<Lock>::BasicTimer(): timer_count_(0), wakeups_saved_(0), wheel_tick_(std::chrono::milliseconds(10)),
+    wheel_levels_(4),
+    wheel_epoch_(std::chrono::steady_clock::now()), wheel_base_(0), wheel_count_(0),
+    wheel_slots_(wheel_levels_ * WHEEL_SLOTS, nullptr),
+    wheel_bitmap_(wheel_levels_ * WHEEL_SLOTS / 64, 0) {
 }
 
-size_t Timer::get_timer_count() const {
-    std::shared_lock<std::shared_mutex> lock(mtx);
-    return timer_map_.size();
+template <typename Lock>
+bool BasicTimer<Lock>::configure_wheel(int tick_ms, int levels) {
+    std::unique_lock<Mutex> lock(mtx);
+    if (tick_ms <= 0 || levels <= 0 || levels > WHEEL_MAX_LEVELS || wheel_count_ > 0) {
+        return false;
+    }
+    wheel_tick_ = std::chrono::milliseconds(tick_ms);
+    wheel_levels_ = levels;
+    wheel_epoch_ = std::chrono::steady_clock::now();
+    wheel_base_ = 0;
+    wheel_slots_.assign(levels * WHEEL_SLOTS, nullptr);
+    wheel_bitmap_.assign(levels * WHEEL_SLOTS / 64, 0);
+    return true;
+}
+
+template <typename Lock>
+size_t BasicTimer<Lock>::get_timer_count() const {
+    std::shared_lock<Mutex> lock(mtx);
+    return timer_count_;
+}
+
+template <typename Lock>
+void BasicTimer<Lock>::heap_set(size_t index, TimerInfo* timer) {
+    timer_heap_[index] = timer;
+    timer->heap_index = index;
 }
 
-void Timer::timer_add_queue(std::shared_ptr<TimerInfo> timer) {
-    auto it = timer_queue_.begin();
-    while (it != timer_queue_.end() && (*it)->next_fire <= timer->next_fire) {
-        ++it;
+template <typename Lock>
+void BasicTimer<Lock>::heap_sift_up(size_t index) {
+    TimerInfo* timer = timer_heap_[index];
+    while (index > 0) {
+        size_t parent = (index - 1) / 2;
+        if (timer_heap_[parent]->deadline <= timer->deadline) {
+            break;
+        }
+        heap_set(index, timer_heap_[parent]);
+        index = parent;
     }
-    timer->updated = false;
-    timer_queue_.insert(it, timer);
+    heap_set(index, timer);
 }
 
-int Timer::find_id() {
-        int id = next_timer_id_;
-        while (timer_map_.find(id) != timer_map_.end()) {
-            id++;
-            if (id <= 0) {
-                return -1;
-            }
+template <typename Lock>
+void BasicTimer<Lock>::heap_sift_down(size_t index) {
+    TimerInfo* timer = timer_heap_[index];
+    size_t size = timer_heap_.size();
+    while (true) {
+        size_t child = index * 2 + 1;
+        if (child >= size) {
+            break;
         }
-        next_timer_id_ = id + 1;
-        return id;
+        if (child + 1 < size && timer_heap_[child + 1]->deadline < timer_heap_[child]->deadline) {
+            child++;
+        }
+        if (timer->deadline <= timer_heap_[child]->deadline) {
+            break;
+        }
+        heap_set(index, timer_heap_[child]);
+        index = child;
     }
+    heap_set(index, timer);
+}
+
+template <typename Lock>
+void BasicTimer<Lock>::heap_push(TimerInfo* timer) {
+    timer_heap_.push_back(timer);
+    heap_sift_up(timer_heap_.size() - 1);
+}
 
+template <typename Lock>
+void BasicTimer<Lock>::heap_erase(TimerInfo* timer) {
+    size_t index = timer->heap_index;
+    if (index == NOT_QUEUED) {
+        return;
+    }
+    timer->heap_index = NOT_QUEUED;
+    TimerInfo* last = timer_heap_.back();
+    timer_heap_.pop_back();
+    if (last == timer) {
+        return;
+    }
+    heap_set(index, last);
+    heap_update(last);
+}
 
-int Timer::add_timer(int interval_ms, TimerCallback callback, bool repeat) { 
-    std::unique_lock<std::shared_mutex> lock(mtx);
-    if (interval_ms <= 0 || !callback) {
-        return -1;
+template <typename Lock>
+void BasicTimer<Lock>::heap_update(TimerInfo* timer) {
+    size_t index = timer->heap_index;
+    if (index > 0 && timer->deadline < timer_heap_[(index - 1) / 2]->deadline) {
+        heap_sift_up(index);
+    } else {
+        heap_sift_down(index);
     }
+}
 
-    int timer_id = find_id();
-    if (timer_id <= 0)
-        return -1;
+template <typename Lock>
+void BasicTimer<Lock>::wheel_add(TimerInfo* timer) {
+    auto since = timer->deadline - wheel_epoch_;
+    if (since.count() <= 0) {
+        timer->expire_tick = 0;
+    } else {
+        timer->expire_tick = (since + wheel_tick_ - std::chrono::nanoseconds(1)) / wheel_tick_;
+    }
+    wheel_insert(timer);
+    wheel_count_++;
+}
 
-    auto now = std::chrono::steady_clock::now();
-    auto interval = std::chrono::milliseconds(interval_ms);
-    auto next_fire = now + interval;
+template <typename Lock>
+void BasicTimer<Lock>::wheel_insert(TimerInfo* timer) {
+    uint64_t expire = std::max(timer->expire_tick, wheel_base_);
+    uint64_t delta = expire - wheel_base_;
+    int level = 0;
 
-    auto timer_info = std::make_shared<TimerInfo>(
-        timer_id, std::move(callback), next_fire, interval, repeat);
+    while (level < wheel_levels_ - 1 && delta >= (uint64_t(1) << (WHEEL_BITS * (level + 1)))) {
+        level++;
+    }
+    uint64_t range = uint64_t(1) << (WHEEL_BITS * wheel_levels_);
+    if (delta >= range) {
+        expire = wheel_base_ + range - 1;
+    }
 
-    timer_map_[timer_id] = timer_info;
-    timer_add_queue(timer_info);
-    return timer_id;
+    size_t slot = level * WHEEL_SLOTS + ((expire >> (WHEEL_BITS * level)) & WHEEL_MASK);
+    TimerInfo* head = wheel_slots_[slot];
+    timer->wheel_slot = slot;
+    timer->wheel_prev = nullptr;
+    timer->wheel_next = head;
+    if (head) {
+        head->wheel_prev = timer;
+    }
+    wheel_slots_[slot] = timer;
+    wheel_bitmap_[slot / 64] |= uint64_t(1) << (slot % 64);
 }
 
-bool Timer::update_timer_interval(int timer_id, int interval_ms) {
-    std::unique_lock<std::shared_mutex> lock(mtx);
-    auto it = timer_map_.find(timer_id);
-    if (it == timer_map_.end() || interval_ms <= 0) {
-        return false;
+template <typename Lock>
+void BasicTimer<Lock>::wheel_remove(TimerInfo* timer) {
+    size_t slot = timer->wheel_slot;
+    if (slot == NOT_QUEUED) {
+        return;
+    }
+    if (timer->wheel_prev) {
+        timer->wheel_prev->wheel_next = timer->wheel_next;
+    } else {
+        wheel_slots_[slot] = timer->wheel_next;
     }
-    timer_queue_.remove(it->second);
+    if (timer->wheel_next) {
+        timer->wheel_next->wheel_prev = timer->wheel_prev;
+    }
+    if (!wheel_slots_[slot]) {
+        wheel_bitmap_[slot / 64] &= ~(uint64_t(1) << (slot % 64));
+    }
+    timer->wheel_slot = NOT_QUEUED;
+    timer->wheel_prev = timer->wheel_next = nullptr;
+    wheel_count_--;
+}
 
-    auto now = std::chrono::steady_clock::now();
-    auto new_interval = std::chrono::milliseconds(interval_ms);
+template <typename Lock>
+void BasicTimer<Lock>::wheel_cascade(int level, size_t index) {
+    size_t slot = level * WHEEL_SLOTS + index;
+    TimerInfo* timer = wheel_slots_[slot];
+    wheel_slots_[slot] = nullptr;
+    wheel_bitmap_[slot / 64] &= ~(uint64_t(1) << (slot % 64));
+    while (timer) {
+        TimerInfo* next = timer->wheel_next;
+        wheel_insert(timer);
+        timer = next;
+    }
+}
 
-    it->second->interval = new_interval;
-    it->second->next_fire = now + new_interval;
-    it->second->updated = true;
-    return true;
+template <typename Lock>
+int BasicTimer<Lock>::wheel_find_slot(size_t from) const {
+    for (size_t word = from / 64; word < WHEEL_SLOTS / 64; word++) {
+        uint64_t bits = wheel_bitmap_[word];
+        if (word == from / 64) {
+            bits &= ~uint64_t(0) << (from % 64);
+        }
+        if (bits) {
+            return word * 64 + __builtin_ctzll(bits);
+        }
+    }
+    return -1;
 }
 
-void Timer::process_timers() {
-    auto now = std::chrono::steady_clock::now();
-    std::unique_lock<std::shared_mutex> lock(mtx);
+template <typename Lock>
+void BasicTimer<Lock>::wheel_advance(TimePoint now) {
+    if (now < wheel_epoch_) {
+        return;
+    }
+    uint64_t target = (now - wheel_epoch_) / wheel_tick_;
 
-    while (!timer_queue_.empty()) {
-        auto timer_info = timer_queue_.front();
+    while (wheel_base_ <= target) {
+        if (wheel_count_ == 0) {
+            wheel_base_ = target + 1;
+            break;
+        }
 
-        if (!timer_info->active) {
-            dbg("timer not active %d", timer_info->active);
-            timer_queue_.pop_front();
+        size_t index = wheel_base_ & WHEEL_MASK;
+        int slot = wheel_find_slot(index);
+        if (slot != static_cast<int>(index)) {
+            uint64_t next = slot < 0 ? (wheel_base_ | WHEEL_MASK) + 1 : wheel_base_ - index + slot;
+            wheel_base_ = std::min(next, target + 1);
+            wheel_cascade_boundary();
             continue;
         }
-        auto remaining = timer_info->next_fire - now;
-        if (remaining > std::chrono::microseconds(500)) {
+
+        TimerInfo* timer = wheel_slots_[index];
+        while (timer) {
+            TimerInfo* next = timer->wheel_next;
+            wheel_remove(timer);
+            expired_.push_back(timer);
+            timer = next;
+        }
+        wheel_base_++;
+        wheel_cascade_boundary();
+    }
+}
+
+// Runs as soon as wheel_base_ reaches a rotation boundary, even when that is
+// past the current target, so wheel_next_deadline() sees the cascaded
+// timers in level 0. A second call for the same boundary finds the upper
+// slots empty.
+template <typename Lock>
+void BasicTimer<Lock>::wheel_cascade_boundary() {
+    if ((wheel_base_ & WHEEL_MASK) != 0) {
+        return;
+    }
+    for (int level = 1; level < wheel_levels_; level++) {
+        size_t upper = (wheel_base_ >> (WHEEL_BITS * level)) & WHEEL_MASK;
+        wheel_cascade(level, upper);
+        if (upper != 0) {
             break;
         }
+    }
+}
 
-        timer_queue_.pop_front();
-        lock.unlock();
-        try {
-            timer_info->callback(timer_info->id);
-       } catch (const std::exception& e) {
-            dbg("Exception in timer callback for timer %d %s", timer_info->id, e.what().c_str());
-            timer_info->active = false;
-        } catch (...) {
-            dbg("Unknown exception in timer callback for timer %d", timer_info->id);
-            timer_info->active = false;
+template <typename Lock>
+bool BasicTimer<Lock>::wheel_next_deadline(TimePoint& deadline) const {
+    if (wheel_count_ == 0) {
+        return false;
+    }
+    size_t index = wheel_base_ & WHEEL_MASK;
+    int slot = wheel_find_slot(index);
+    uint64_t tick = slot < 0 ? (wheel_base_ | WHEEL_MASK) + 1 : wheel_base_ - index + slot;
+    deadline = wheel_epoch_ + wheel_tick_ * tick;
+    return true;
+}
+
+template <typename Lock>
+void BasicTimer<Lock>::schedule(TimerInfo* timer) {
+    if (timer->mode == TimerMode::WHEEL) {
+        wheel_add(timer);
+    } else {
+        heap_push(timer);
+    }
+}
+
+template <typename Lock>
+void BasicTimer<Lock>::unschedule(TimerInfo* timer) {
+    heap_erase(timer);
+    wheel_remove(timer);
+}
+
+// Like the kernel's timer slack: the deadline moves to the coarsest
+// power-of-two nanosecond boundary inside [next_fire, next_fire + slack], so
+// timers with overlapping windows tend to land on the same instant.
+template <typename Lock>
+void BasicTimer<Lock>::set_next_fire(TimerInfo* timer, TimePoint next_fire) {
+    timer->next_fire = next_fire;
+    timer->deadline = next_fire;
+    if (timer->slack.count() <= 0) {
+        return;
+    }
+    uint64_t start = next_fire.time_since_epoch().count();
+    uint64_t limit = start + timer->slack.count();
+    uint64_t mask = start ^ limit;
+    if (mask == 0) {
+        return;
+    }
+    int bit = 63 - __builtin_clzll(mask);
+    limit &= ~((uint64_t(1) << bit) - 1);
+    timer->deadline = TimePoint(std::chrono::steady_clock::duration(limit));
+}
+
+template <typename Lock>
+typename BasicTimer<Lock>::TimerInfo* BasicTimer<Lock>::alloc_timer() {
+    if (free_slots_.empty()) {
+        size_t base = timer_slab_.size() * TIMER_CHUNK_SIZE;
+        if (base + TIMER_CHUNK_SIZE > TIMER_INDEX_MASK) {
+            return nullptr;
         }
-        lock.lock();
-        if (timer_info->repeat && timer_info->active) {
-            timer_info->next_fire = now + timer_info->interval;
-            timer_add_queue(timer_info);
-        } else {
-            timer_info->active = false;
+        timer_slab_.push_back(std::make_unique<TimerChunk>());
+        for (size_t i = TIMER_CHUNK_SIZE; i > 0; i--) {
+            free_slots_.push_back(static_cast<uint32_t>(base + i - 1));
         }
     }
+    uint32_t index = free_slots_.back();
+    free_slots_.pop_back();
+    TimerInfo* timer = &(*timer_slab_[index >> TIMER_CHUNK_BITS])[index & TIMER_CHUNK_MASK];
+    uint32_t gen = ((static_cast<uint32_t>(timer->id) >> TIMER_INDEX_BITS) + 1) & TIMER_GEN_MASK;
+    timer->id = static_cast<int>((gen << TIMER_INDEX_BITS) | (index + 1));
+    timer_count_++;
+    return timer;
+}
 
-    for (auto it = timer_map_.begin(); it != timer_map_.end();) {
-        if (!it->second->active) {
-            next_timer_id_ = it->second->id;
-            it = timer_map_.erase(it);
-        } else {
-            if (it->second->updated)
-                timer_add_queue(it->second);
-            ++it;
-        }
+template <typename Lock>
+void BasicTimer<Lock>::free_timer(TimerInfo* timer) {
+    timer->callback = nullptr;
+    free_slots_.push_back((static_cast<uint32_t>(timer->id) & TIMER_INDEX_MASK) - 1);
+}
+
+// Ids of freed timers carry an older generation than the slot, so a stale
+// id does not find the timer that reused it.
+template <typename Lock>
+typename BasicTimer<Lock>::TimerInfo* BasicTimer<Lock>::find_timer(int timer_id) {
+    size_t index = (static_cast<uint32_t>(timer_id) & TIMER_INDEX_MASK) - 1;
+    if (timer_id <= 0 || (index >> TIMER_CHUNK_BITS) >= timer_slab_.size()) {
+        return nullptr;
+    }
+    TimerInfo* timer = &(*timer_slab_[index >> TIMER_CHUNK_BITS])[index & TIMER_CHUNK_MASK];
+    return timer->active && timer->id == timer_id ? timer : nullptr;
+}
+
+// The slot is reused right away unless its callback is still running.
+template <typename Lock>
+void BasicTimer<Lock>::release_timer(TimerInfo* timer) {
+    if (!timer->active) {
+        return;
+    }
+    timer->active = false;
+    unschedule(timer);
+    timer_count_--;
+    if (!timer->firing) {
+        free_timer(timer);
+    }
+}
+
+template <typename Lock>
+int BasicTimer<Lock>::add_timer(int interval_ms, TimerCallback callback, bool repeat, TimerMode mode) {
+    return add_timer(std::chrono::milliseconds(interval_ms), std::move(callback), repeat, mode);
+}
+
+template <typename Lock>
+int BasicTimer<Lock>::add_timer(std::chrono::nanoseconds interval, TimerCallback callback,
+                                bool repeat, TimerMode mode) {
+    return add_timer(interval, std::chrono::nanoseconds::zero(), std::move(callback), repeat, mode);
+}
+
+template <typename Lock>
+int BasicTimer<Lock>::add_timer(std::chrono::nanoseconds interval, std::chrono::nanoseconds slack,
+                                TimerCallback callback, bool repeat, TimerMode mode) {
+    std::unique_lock<Mutex> lock(mtx);
+    if (interval.count() <= 0 || slack.count() < 0 || !callback) {
+        return -1;
+    }
+
+    TimerInfo* timer = alloc_timer();
+    if (!timer) {
+        return -1;
+    }
+
+    timer->callback = std::move(callback);
+    timer->interval = interval;
+    timer->slack = slack;
+    set_next_fire(timer, std::chrono::steady_clock::now() + interval);
+    timer->repeat = repeat;
+    timer->active = true;
+    timer->mode = mode;
+    schedule(timer);
+    return timer->id;
+}
+
+template <typename Lock>
+bool BasicTimer<Lock>::update_timer_interval(int timer_id, int interval_ms) {
+    return update_timer_interval(timer_id, std::chrono::milliseconds(interval_ms));
+}
+
+template <typename Lock>
+bool BasicTimer<Lock>::update_timer_interval(int timer_id, std::chrono::nanoseconds interval) {
+    std::unique_lock<Mutex> lock(mtx);
+    TimerInfo* timer = find_timer(timer_id);
+    if (!timer || interval.count() <= 0) {
+        return false;
     }
+
+    timer->interval = interval;
+    set_next_fire(timer, std::chrono::steady_clock::now() + interval);
+    if (timer->heap_index != NOT_QUEUED) {
+        heap_update(timer);
+    } else if (timer->wheel_slot != NOT_QUEUED) {
+        wheel_remove(timer);
+        wheel_add(timer);
+    }
+    return true;
 }
 
-int Timer::calculate_timeout(int default_timeout_ms) const { 
-    std::unique_lock<std::shared_mutex> lock(mtx);
-    if (timer_queue_.empty()) {
-        return default_timeout_ms;
+template <typename Lock>
+void BasicTimer<Lock>::fire_timer(TimerInfo* timer, std::unique_lock<Mutex>& lock, TimePoint now) {
+    TimerCallback callback = std::move(timer->callback);
+    int timer_id = timer->id;
+    bool failed = false;
+    timer->firing = true;
+    LoopCounters* stats = stats_.load(std::memory_order_relaxed);
+    TimePoint start;
+    if (stats) {
+        start = std::chrono::steady_clock::now();
+        stats->record_lateness(start - timer->next_fire);
+        stats->set_current(-1, timer_id);
+    }
+    lock.unlock();
+    try {
+        callback(timer_id);
+    } catch (const std::exception& e) {
+        dbg("Exception in timer callback for timer %d %s", timer_id, e.what());
+        failed = true;
+    } catch (...) {
+        dbg("Unknown exception in timer callback for timer %d", timer_id);
+        failed = true;
     }
+    if (stats) {
+        stats->record_callback(std::chrono::steady_clock::now() - start, -1, timer_id);
+        stats->set_current(-1, -1);
+    }
+    lock.lock();
+    timer->firing = false;
+    if (!timer->active) {
+        free_timer(timer);
+    } else if (timer->repeat && !failed) {
+        timer->callback = std::move(callback);
+        set_next_fire(timer, now + timer->interval);
+        schedule(timer);
+    } else {
+        release_timer(timer);
+    }
+}
+
+// Timers that came due since the previous pass and fire together here would
+// each have needed a wakeup of their own without slack. If no slack-free
+// timer is among them, one of them still paid for this wakeup.
+template <typename Lock>
+void BasicTimer<Lock>::count_fired(const TimerInfo* timer, size_t& exact, size_t& slacked) const {
+    if (timer->next_fire <= last_process_) {
+        return;
+    }
+    if (timer->slack.count() > 0) {
+        slacked++;
+    } else {
+        exact++;
+    }
+}
 
+template <typename Lock>
+void BasicTimer<Lock>::process_timers() {
     auto now = std::chrono::steady_clock::now();
-    auto next_timer = *timer_queue_.begin();
+    std::unique_lock<Mutex> lock(mtx);
+    size_t exact = 0;
+    size_t slacked = 0;
 
-    if (!next_timer->active) {
-        return 0;
+    // Anything past its exact deadline rides along with this wakeup even if
+    // its slack would allow it to wait.
+    while (!timer_heap_.empty()) {
+        TimerInfo* top = timer_heap_.front();
+        if (top->deadline > now && top->next_fire > now) {
+            break;
+        }
+
+        heap_erase(top);
+        count_fired(top, exact, slacked);
+        fire_timer(top, lock, now);
     }
 
-    auto time_to_next = std::chrono::duration_cast<std::chrono::milliseconds>(
-        next_timer->next_fire - now + std::chrono::microseconds(500));
+    wheel_advance(now);
+    // An entry cancelled by an earlier callback may already hold a new,
+    // scheduled timer, so only fire slots that are still unqueued.
+    for (size_t i = 0; i < expired_.size(); i++) {
+        TimerInfo* timer = expired_[i];
+        if (timer->active && !timer->firing && timer->heap_index == NOT_QUEUED &&
+            timer->wheel_slot == NOT_QUEUED) {
+            count_fired(timer, exact, slacked);
+            fire_timer(timer, lock, now);
+        }
+    }
+    expired_.clear();
+
+    if (slacked > 0) {
+        wakeups_saved_ += exact > 0 ? slacked : slacked - 1;
+    }
+    last_process_ = now;
+}
 
-    if (time_to_next.count() <= 0) {
-        return 0;
+template <typename Lock>
+typename BasicTimer<Lock>::TimePoint BasicTimer<Lock>::next_deadline() const {
+    std::unique_lock<Mutex> lock(mtx);
+    TimePoint deadline = TimePoint::max();
+    wheel_next_deadline(deadline);
+    if (!timer_heap_.empty()) {
+        deadline = std::min(deadline, timer_heap_.front()->deadline);
     }
+    return deadline;
+}
 
-    int timeout = static_cast<int>(time_to_next.count());
+template <typename Lock>
+std::chrono::nanoseconds BasicTimer<Lock>::calculate_timeout(
+        std::chrono::nanoseconds default_timeout) const {
+    TimePoint deadline = next_deadline();
+    if (deadline == TimePoint::max()) {
+        return default_timeout;
+    }
 
-    if (default_timeout_ms < 0) {
-        return timeout;
+    auto time_to_next = std::max(deadline - std::chrono::steady_clock::now(),
+                                 std::chrono::steady_clock::duration::zero());
+    if (default_timeout.count() < 0) {
+        return time_to_next;
     }
-    return std::min(timeout, default_timeout_ms);
+    return std::min<std::chrono::nanoseconds>(time_to_next, default_timeout);
 }
 
-bool Timer::remove_timer(int timer_id) {
-    std::unique_lock<std::shared_mutex> lock(mtx);
-    auto it = timer_map_.find(timer_id);
-    if (it == timer_map_.end()) {
+template <typename Lock>
+uint64_t BasicTimer<Lock>::get_wakeups_saved() const {
+    std::shared_lock<Mutex> lock(mtx);
+    return wakeups_saved_;
+}
+
+template <typename Lock>
+bool BasicTimer<Lock>::remove_timer(int timer_id) {
+    std::unique_lock<Mutex> lock(mtx);
+    TimerInfo* timer = find_timer(timer_id);
+    if (!timer) {
         return false;
     }
     dbg("timer deactived %d", timer_id);
-    it->second->active = false;
+    release_timer(timer);
     return true;
 }
 
+template <typename Lock>
+void BasicTimer<Lock>::set_owner_thread(std::thread::id owner) {
+    Lock::bind(mtx, owner);
+}
+
+template class BasicTimer<ThreadSafe>;
+template class BasicTimer<NoLock>;
@@ -0,0 +1,333 @@
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/udp.h>
+#include "udp_endpoint.h"
+//#define DEBUG
+
+#ifdef DEBUG
+#define dbg(a...) do { \
+    std::cerr << "[DEBUG] " << __FILE__ << ":" << __LINE__ << ":" << __FUNCTION__ <<" "; \
+    fprintf(stderr, a); \
+    std::cerr << std::endl; \
+} while(0)
+#else
+#define dbg(fmt, ...) do { } while(0)
+#endif
+
+static constexpr size_t GRO_CONTROL_SIZE = CMSG_SPACE(sizeof(int));
+static constexpr size_t GSO_CONTROL_SIZE = CMSG_SPACE(sizeof(uint16_t));
+
+static bool same_peer(const sockaddr_in& a, const sockaddr_in& b) {
+    return a.sin_port == b.sin_port && a.sin_addr.s_addr == b.sin_addr.s_addr;
+}
+
+template <typename Lock>
+BasicUdpEndpoint<Lock>::BasicUdpEndpoint(BasicPoller<Lock>& poller, size_t batch,
+                                         size_t datagram_size)
+    : poller_(poller), batch_(std::max<size_t>(batch, 1)),
+    datagram_size_(std::max<size_t>(datagram_size, 1)),
+    out_data_(new char[batch_ * datagram_size_]), out_len_(batch_), out_peer_(batch_),
+    tx_iov_(batch_), tx_msgs_(batch_), tx_count_(batch_),
+    tx_control_(new char[batch_ * GSO_CONTROL_SIZE]) {
+}
+
+template <typename Lock>
+BasicUdpEndpoint<Lock>::~BasicUdpEndpoint() {
+    close();
+}
+
+template <typename Lock>
+bool BasicUdpEndpoint<Lock>::open(int port, ReceiveCallback callback, const char* addr,
+                                  bool offload) {
+    if (fd_ >= 0 || !callback) {
+        return false;
+    }
+
+    fd_ = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd_ < 0) {
+        perror("socket");
+        return false;
+    }
+
+    sockaddr_in local{};
+    local.sin_family = AF_INET;
+    local.sin_port = htons(port);
+    local.sin_addr.s_addr = INADDR_ANY;
+    if (addr && inet_pton(AF_INET, addr, &local.sin_addr) != 1) {
+        std::cerr << "Invalid address " << addr << std::endl;
+        close();
+        return false;
+    }
+    if (bind(fd_, (sockaddr*)&local, sizeof(local)) < 0) {
+        perror("bind");
+        close();
+        return false;
+    }
+    socklen_t len = sizeof(local);
+    if (getsockname(fd_, (sockaddr*)&local, &len) == 0) {
+        port_ = ntohs(local.sin_port);
+    }
+
+    int on = 1;
+    int zero = 0;
+    gro_ = offload && setsockopt(fd_, IPPROTO_UDP, UDP_GRO, &on, sizeof(on)) == 0;
+    gso_ = offload && setsockopt(fd_, IPPROTO_UDP, UDP_SEGMENT, &zero, sizeof(zero)) == 0;
+
+    // A GRO buffer holds many datagrams, so fewer slots cover the same batch.
+    rx_slots_ = gro_ ? std::max<size_t>(batch_ / 4, 1) : batch_;
+    rx_size_ = gro_ ? GRO_BUFFER_SIZE : datagram_size_;
+    rx_data_.reset(new char[rx_slots_ * rx_size_]);
+    rx_control_.reset(new char[rx_slots_ * GRO_CONTROL_SIZE]);
+    rx_iov_.assign(rx_slots_, iovec{});
+    rx_msgs_.assign(rx_slots_, mmsghdr{});
+    rx_peers_.assign(rx_slots_, sockaddr_in{});
+    delivered_.reserve(gro_ ? rx_slots_ * GRO_MAX_SEGMENTS : rx_slots_);
+    for (size_t i = 0; i < rx_slots_; i++) {
+        rx_iov_[i].iov_base = rx_data_.get() + i * rx_size_;
+        rx_iov_[i].iov_len = rx_size_;
+        msghdr& hdr = rx_msgs_[i].msg_hdr;
+        hdr.msg_name = &rx_peers_[i];
+        hdr.msg_iov = &rx_iov_[i];
+        hdr.msg_iovlen = 1;
+    }
+
+    callback_ = std::move(callback);
+    auto handler = [this](int fd, short events, short revents) {
+        (void)fd;
+        (void)events;
+        handle_event(revents);
+    };
+    events_ = POLLIN;
+    if (!poller_.add(fd_, events_, handler)) {
+        close();
+        return false;
+    }
+    dbg("udp endpoint on port %d, gro %d gso %d", port_, gro_, gso_);
+    return true;
+}
+
+template <typename Lock>
+void BasicUdpEndpoint<Lock>::close() {
+    if (fd_ < 0) {
+        return;
+    }
+    poller_.remove(fd_);
+    ::close(fd_);
+    fd_ = -1;
+    out_head_ = 0;
+    out_count_ = 0;
+}
+
+template <typename Lock>
+bool BasicUdpEndpoint<Lock>::send(const void* data, size_t len, const sockaddr_in& peer) {
+    if (fd_ < 0) {
+        return false;
+    }
+
+    if (len > datagram_size_) {
+        flush();
+        if (sendto(fd_, data, len, MSG_DONTWAIT, (const sockaddr*)&peer, sizeof(peer)) < 0) {
+            dropped_++;
+            return false;
+        }
+        sent_++;
+        return true;
+    }
+
+    if (out_count_ == batch_) {
+        flush();
+        if (out_count_ == batch_) {
+            dropped_++;
+            return false;
+        }
+    }
+    size_t slot = (out_head_ + out_count_) % batch_;
+    memcpy(out_data_.get() + slot * datagram_size_, data, len);
+    out_len_[slot] = len;
+    out_peer_[slot] = peer;
+    out_count_++;
+    set_events(POLLIN | POLLOUT);
+    return true;
+}
+
+// Groups the queued datagrams into messages. With GSO a run of datagrams to
+// the same peer, all as long as the first except possibly the last, goes
+// out as one message segmented by the kernel.
+template <typename Lock>
+size_t BasicUdpEndpoint<Lock>::build_messages() {
+    size_t msgs = 0;
+    size_t k = 0;
+    while (k < out_count_) {
+        size_t first = (out_head_ + k) % batch_;
+        size_t len = out_len_[first];
+        size_t run = 1;
+        size_t bytes = len;
+        while (gso_ && len > 0 && k + run < out_count_ && run < GRO_MAX_SEGMENTS) {
+            size_t next = (out_head_ + k + run) % batch_;
+            size_t next_len = out_len_[next];
+            if (!same_peer(out_peer_[next], out_peer_[first]) || next_len == 0 ||
+                next_len > len || bytes + next_len > GSO_MAX_BYTES) {
+                break;
+            }
+            bytes += next_len;
+            run++;
+            if (next_len < len) {
+                break;
+            }
+        }
+
+        for (size_t r = 0; r < run; r++) {
+            size_t slot = (out_head_ + k + r) % batch_;
+            tx_iov_[k + r].iov_base = out_data_.get() + slot * datagram_size_;
+            tx_iov_[k + r].iov_len = out_len_[slot];
+        }
+        msghdr& hdr = tx_msgs_[msgs].msg_hdr;
+        hdr = msghdr{};
+        hdr.msg_name = &out_peer_[first];
+        hdr.msg_namelen = sizeof(sockaddr_in);
+        hdr.msg_iov = &tx_iov_[k];
+        hdr.msg_iovlen = run;
+        if (run > 1) {
+            hdr.msg_control = tx_control_.get() + msgs * GSO_CONTROL_SIZE;
+            hdr.msg_controllen = GSO_CONTROL_SIZE;
+            cmsghdr* cmsg = CMSG_FIRSTHDR(&hdr);
+            cmsg->cmsg_level = IPPROTO_UDP;
+            cmsg->cmsg_type = UDP_SEGMENT;
+            cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+            uint16_t segment = len;
+            memcpy(CMSG_DATA(cmsg), &segment, sizeof(segment));
+        }
+        tx_count_[msgs] = run;
+        msgs++;
+        k += run;
+    }
+    return msgs;
+}
+
+template <typename Lock>
+bool BasicUdpEndpoint<Lock>::flush() {
+    bool ok = true;
+    while (fd_ >= 0 && out_count_ > 0) {
+        size_t msgs = build_messages();
+        int n = sendmmsg(fd_, tx_msgs_.data(), msgs, MSG_DONTWAIT);
+        size_t done = 0;
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                set_events(POLLIN | POLLOUT);
+                return ok;
+            }
+            // Segmentation offload can be refused per route or device.
+            if (gso_ && tx_count_[0] > 1 && (errno == EIO || errno == EINVAL)) {
+                dbg("disabling gso: %s", strerror(errno));
+                gso_ = false;
+                continue;
+            }
+            dbg("sendmmsg failed: %s", strerror(errno));
+            done = tx_count_[0];
+            dropped_ += done;
+            ok = false;
+        } else {
+            for (int i = 0; i < n; i++) {
+                done += tx_count_[i];
+            }
+            sent_ += done;
+        }
+        out_head_ = (out_head_ + done) % batch_;
+        out_count_ -= done;
+    }
+    set_events(POLLIN);
+    return ok;
+}
+
+template <typename Lock>
+void BasicUdpEndpoint<Lock>::handle_event(short revents) {
+    if (revents & POLLERR) {
+        // Clears a pending ICMP error so it is not reported again.
+        int error = 0;
+        socklen_t len = sizeof(error);
+        getsockopt(fd_, SOL_SOCKET, SO_ERROR, &error, &len);
+        dbg("udp socket error: %s", strerror(error));
+    }
+    if (revents & POLLIN) {
+        receive();
+    }
+    if (fd_ >= 0 && (revents & POLLOUT)) {
+        flush();
+    }
+}
+
+template <typename Lock>
+void BasicUdpEndpoint<Lock>::receive() {
+    for (size_t round = 0; round < MAX_RECV_ROUNDS && fd_ >= 0; round++) {
+        for (size_t i = 0; i < rx_slots_; i++) {
+            msghdr& hdr = rx_msgs_[i].msg_hdr;
+            hdr.msg_namelen = sizeof(sockaddr_in);
+            hdr.msg_control = gro_ ? rx_control_.get() + i * GRO_CONTROL_SIZE : nullptr;
+            hdr.msg_controllen = gro_ ? GRO_CONTROL_SIZE : 0;
+            hdr.msg_flags = 0;
+        }
+        int n = recvmmsg(fd_, rx_msgs_.data(), rx_slots_, MSG_DONTWAIT, nullptr);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                std::cerr << "recvmmsg failed: " << strerror(errno) << std::endl;
+            }
+            return;
+        }
+
+        delivered_.clear();
+        for (int i = 0; i < n; i++) {
+            msghdr& hdr = rx_msgs_[i].msg_hdr;
+            const char* data = static_cast<const char*>(rx_iov_[i].iov_base);
+            size_t len = rx_msgs_[i].msg_len;
+            if (hdr.msg_flags & MSG_TRUNC) {
+                dropped_++;
+                continue;
+            }
+            size_t segment = len;
+            for (cmsghdr* cmsg = CMSG_FIRSTHDR(&hdr); cmsg; cmsg = CMSG_NXTHDR(&hdr, cmsg)) {
+                if (cmsg->cmsg_level == IPPROTO_UDP && cmsg->cmsg_type == UDP_GRO) {
+                    int gso_size;
+                    memcpy(&gso_size, CMSG_DATA(cmsg), sizeof(gso_size));
+                    segment = gso_size > 0 ? gso_size : len;
+                }
+            }
+            if (len == 0) {
+                delivered_.push_back({data, 0, rx_peers_[i]});
+            }
+            for (size_t off = 0; off < len; off += segment) {
+                delivered_.push_back({data + off, std::min(segment, len - off), rx_peers_[i]});
+            }
+        }
+        received_ += delivered_.size();
+        if (!delivered_.empty()) {
+            callback_(delivered_.data(), delivered_.size());
+        }
+        if (static_cast<size_t>(n) < rx_slots_) {
+            return;
+        }
+    }
+}
+
+template <typename Lock>
+void BasicUdpEndpoint<Lock>::set_events(short events) {
+    if (events == events_ || fd_ < 0) {
+        return;
+    }
+    events_ = events;
+    if (!poller_.update_events(fd_, events_)) {
+        std::cerr << "Failed to update events for fd " << fd_ << std::endl;
+    }
+}
+
+template class BasicUdpEndpoint<ThreadSafe>;
+template class BasicUdpEndpoint<NoLock>;
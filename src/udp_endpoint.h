@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include "poller.h"
+
+// UDP socket on a Poller that moves datagrams in batches. A wakeup drains
+// the socket with recvmmsg into a preallocated ring of buffers and hands
+// each batch to one callback. Outgoing datagrams are queued and flushed
+// with a single sendmmsg once the socket is writable, normally on the next
+// loop iteration. Where the kernel supports it, UDP_GRO lets one receive
+// buffer carry several datagrams and UDP_SEGMENT sends a run of equal sized
+// datagrams to one peer as a single message.
+template <typename Lock>
+class BasicUdpEndpoint {
+public:
+    struct Datagram {
+        const char* data;
+        size_t len;
+        sockaddr_in peer;
+    };
+
+    // The datagrams point into the receive ring and are only valid during
+    // the call.
+    using ReceiveCallback = std::function<void(const Datagram* datagrams, size_t count)>;
+
+    static constexpr size_t DEFAULT_BATCH = 64;
+    static constexpr size_t DEFAULT_DATAGRAM_SIZE = 2048;
+
+    // batch is the number of datagrams per recvmmsg and the length of the
+    // send queue. Larger datagrams are sent unbatched; on receive they are
+    // dropped and counted in dropped(). With GRO on, the receive limit is
+    // GRO_BUFFER_SIZE instead.
+    explicit BasicUdpEndpoint(BasicPoller<Lock>& poller, size_t batch = DEFAULT_BATCH,
+                              size_t datagram_size = DEFAULT_DATAGRAM_SIZE);
+    ~BasicUdpEndpoint();
+
+    BasicUdpEndpoint(const BasicUdpEndpoint&) = delete;
+    BasicUdpEndpoint& operator=(const BasicUdpEndpoint&) = delete;
+
+    // Binds to addr (any address when null) and port (ephemeral when 0).
+    // offload enables GRO/GSO when available.
+    bool open(int port, ReceiveCallback callback, const char* addr = nullptr, bool offload = true);
+
+    // Queues a datagram; false if it could not be queued or sent.
+    bool send(const void* data, size_t len, const sockaddr_in& peer);
+
+    // Sends whatever is queued right away.
+    bool flush();
+
+    void close();
+
+    int fd() const { return fd_; }
+
+    int port() const { return port_; }
+
+    bool gro() const { return gro_; }
+
+    bool gso() const { return gso_; }
+
+    // Datagrams waiting in the send queue.
+    size_t queued() const { return out_count_; }
+
+    uint64_t received() const { return received_; }
+
+    uint64_t sent() const { return sent_; }
+
+    // Outgoing datagrams the kernel refused, plus oversized incoming ones.
+    uint64_t dropped() const { return dropped_; }
+
+private:
+    // GRO hands over at most this many datagrams in one buffer.
+    static constexpr size_t GRO_MAX_SEGMENTS = 64;
+    static constexpr size_t GRO_BUFFER_SIZE = 65535;
+    static constexpr size_t GSO_MAX_BYTES = 65000;
+    // recvmmsg rounds per wakeup before yielding to other fds.
+    static constexpr size_t MAX_RECV_ROUNDS = 16;
+
+    BasicPoller<Lock>& poller_;
+    int fd_{-1};
+    int port_{0};
+    short events_{POLLIN};
+    bool gro_{false};
+    bool gso_{false};
+    size_t batch_;
+    size_t datagram_size_;
+    uint64_t received_{0};
+    uint64_t sent_{0};
+    uint64_t dropped_{0};
+    ReceiveCallback callback_;
+
+    // Receive ring: one buffer, iovec, header and control block per slot.
+    size_t rx_slots_{0};
+    size_t rx_size_{0};
+    std::unique_ptr<char[]> rx_data_;
+    std::vector<iovec> rx_iov_;
+    std::vector<mmsghdr> rx_msgs_;
+    std::vector<sockaddr_in> rx_peers_;
+    std::unique_ptr<char[]> rx_control_;
+    std::vector<Datagram> delivered_;
+
+    // Send ring of batch_ slots, out_count_ of them queued from out_head_.
+    std::unique_ptr<char[]> out_data_;
+    std::vector<size_t> out_len_;
+    std::vector<sockaddr_in> out_peer_;
+    size_t out_head_{0};
+    size_t out_count_{0};
+    std::vector<iovec> tx_iov_;
+    std::vector<mmsghdr> tx_msgs_;
+    // Datagrams carried by each message.
+    std::vector<size_t> tx_count_;
+    std::unique_ptr<char[]> tx_control_;
+
+    void handle_event(short revents);
+
+    void receive();
+
+    void set_events(short events);
+
+    size_t build_messages();
+};
+
+using UdpEndpoint = BasicUdpEndpoint<ThreadSafe>;
+using LocalUdpEndpoint = BasicUdpEndpoint<NoLock>;
@@ -0,0 +1,365 @@
+#include <iostream>
+#include <algorithm>
+#include <unistd.h>
+#include <cstring>
+#include <cerrno>
+#include <csignal>
+#include <ctime>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#include "backend.h"
+//#define DEBUG
+
+#ifdef DEBUG
+#define dbg(a...) do { \
+    std::cerr << "[DEBUG] " << __FILE__ << ":" << __LINE__ << ":" << __FUNCTION__ <<" "; \
+    fprintf(stderr, a); \
+    std::cerr << std::endl; \
+} while(0)
+#else
+#define dbg(fmt, ...) do { } while(0)
+#endif
+
+namespace {
+
+enum : uint64_t {
+    TAG_POLL = 1,
+    TAG_CTRL = 2,
+    TAG_OP = 3,
+};
+
+constexpr int TAG_SHIFT = 56;
+constexpr uint64_t TOKEN_MASK = (uint64_t(1) << TAG_SHIFT) - 1;
+
+uint64_t poll_data(int fd, uint32_t seq) {
+    return (TAG_POLL << TAG_SHIFT) | (uint64_t(seq & 0xffffff) << 32) | uint32_t(fd);
+}
+
+void publish_sqe(unsigned* sq_tail) {
+    __atomic_store_n(sq_tail, *sq_tail + 1, __ATOMIC_RELEASE);
+}
+
+}
+
+UringBackend::UringBackend(unsigned entries)
+    : ring_fd_(-1), sq_ptr_(MAP_FAILED), sq_size_(0), cq_ptr_(MAP_FAILED), cq_size_(0),
+    sqes_(nullptr), sqes_size_(0), sq_entries_(0), next_seq_(1) {
+    io_uring_params params{};
+
+    int fd = syscall(__NR_io_uring_setup, entries, &params);
+    if (fd < 0) {
+        dbg("io_uring_setup failed: %s", strerror(errno));
+        return;
+    }
+
+    if (!(params.features & IORING_FEAT_EXT_ARG)) {
+        dbg("io_uring lacks IORING_FEAT_EXT_ARG");
+        close(fd);
+        return;
+    }
+
+    sq_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        sq_size_ = cq_size_ = std::max(sq_size_, cq_size_);
+    }
+
+    sq_ptr_ = mmap(nullptr, sq_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                   fd, IORING_OFF_SQ_RING);
+    if (sq_ptr_ == MAP_FAILED) {
+        close(fd);
+        return;
+    }
+
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        cq_ptr_ = sq_ptr_;
+    } else {
+        cq_ptr_ = mmap(nullptr, cq_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                       fd, IORING_OFF_CQ_RING);
+        if (cq_ptr_ == MAP_FAILED) {
+            unmap();
+            close(fd);
+            return;
+        }
+    }
+
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        unmap();
+        close(fd);
+        return;
+    }
+    sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+    char* sq = static_cast<char*>(sq_ptr_);
+    sq_head_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sq_mask_ = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    sq_entries_ = params.sq_entries;
+
+    char* cq = static_cast<char*>(cq_ptr_);
+    cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cq_mask_ = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+    ring_fd_ = fd;
+}
+
+UringBackend::~UringBackend() {
+    if (ring_fd_ >= 0) {
+        unmap();
+        close(ring_fd_);
+    }
+}
+
+void UringBackend::unmap() {
+    if (sqes_) {
+        munmap(sqes_, sqes_size_);
+        sqes_ = nullptr;
+    }
+    if (cq_ptr_ != MAP_FAILED && cq_ptr_ != sq_ptr_) {
+        munmap(cq_ptr_, cq_size_);
+    }
+    if (sq_ptr_ != MAP_FAILED) {
+        munmap(sq_ptr_, sq_size_);
+    }
+    sq_ptr_ = cq_ptr_ = MAP_FAILED;
+}
+
+int UringBackend::enter(unsigned to_submit, unsigned min_complete, unsigned flags,
+                        std::chrono::nanoseconds timeout) {
+    io_uring_getevents_arg arg{};
+    timespec ts = to_timespec(timeout);
+
+    if (timeout.count() >= 0) {
+        arg.ts = reinterpret_cast<uint64_t>(&ts);
+    }
+    arg.sigmask_sz = _NSIG / 8;
+
+    return syscall(__NR_io_uring_enter, ring_fd_, to_submit, min_complete,
+                   flags | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+}
+
+io_uring_sqe* UringBackend::get_sqe() {
+    unsigned tail = *sq_tail_;
+    unsigned head = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+
+    if (tail - head >= sq_entries_) {
+        if (enter(tail - head, 0, 0, std::chrono::nanoseconds(-1)) < 0) {
+            dbg("io_uring submit failed: %s", strerror(errno));
+            return nullptr;
+        }
+        head = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+        if (tail - head >= sq_entries_) {
+            return nullptr;
+        }
+    }
+
+    unsigned index = tail & *sq_mask_;
+    io_uring_sqe* sqe = &sqes_[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sq_array_[index] = index;
+    return sqe;
+}
+
+bool UringBackend::queue_poll(int fd, const PollReg& reg) {
+    io_uring_sqe* sqe = get_sqe();
+    if (!sqe) {
+        return false;
+    }
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+    sqe->poll32_events = static_cast<unsigned short>(reg.events);
+    // Multishot polls post a completion per wakeup rather than per check,
+    // which is what edge-triggered means here.
+    if ((reg.mode & POLL_EDGE) && !(reg.mode & POLL_ONESHOT)) {
+        sqe->len = IORING_POLL_ADD_MULTI;
+    }
+    sqe->user_data = poll_data(fd, reg.seq);
+    publish_sqe(sq_tail_);
+    return true;
+}
+
+void UringBackend::queue_poll_remove(int fd, const PollReg& reg) {
+    io_uring_sqe* sqe = get_sqe();
+    if (!sqe) {
+        return;
+    }
+    sqe->opcode = IORING_OP_POLL_REMOVE;
+    sqe->fd = -1;
+    sqe->addr = poll_data(fd, reg.seq);
+    sqe->user_data = TAG_CTRL << TAG_SHIFT;
+    publish_sqe(sq_tail_);
+}
+
+UringBackend::PollReg* UringBackend::find_reg(int fd) {
+    if (fd < 0 || static_cast<size_t>(fd) >= regs_.size() || !regs_[fd].registered) {
+        return nullptr;
+    }
+    return &regs_[fd];
+}
+
+bool UringBackend::add(int fd, short events, unsigned mode) {
+    if (fd < 0 || find_reg(fd)) {
+        return false;
+    }
+    if (static_cast<size_t>(fd) >= regs_.size()) {
+        regs_.resize(fd + 1, PollReg{0, 0, 0, 0, 0, false, false});
+    }
+    PollReg& reg = regs_[fd];
+    reg.registered = true;
+    reg.events = events;
+    reg.mode = mode;
+    reg.seq = next_seq_++;
+    reg.armed = queue_poll(fd, reg);
+    if (!reg.armed) {
+        rearm_.push_back(fd);
+    }
+    return true;
+}
+
+bool UringBackend::modify(int fd, short events, unsigned mode) {
+    PollReg* reg = find_reg(fd);
+    if (!reg) {
+        return false;
+    }
+    reg->events = events;
+    reg->mode = mode;
+    if (reg->armed) {
+        queue_poll_remove(fd, *reg);
+        reg->seq = next_seq_++;
+        reg->armed = queue_poll(fd, *reg);
+        if (!reg->armed) {
+            rearm_.push_back(fd);
+        }
+    } else if (mode & POLL_ONESHOT) {
+        // Disarmed after its report; prepare() skips it if already queued.
+        rearm_.push_back(fd);
+    }
+    return true;
+}
+
+bool UringBackend::remove(int fd) {
+    PollReg* reg = find_reg(fd);
+    if (!reg) {
+        return false;
+    }
+    if (reg->armed) {
+        queue_poll_remove(fd, *reg);
+    }
+    reg->registered = false;
+    reg->armed = false;
+    return true;
+}
+
+bool UringBackend::submit(const AsyncOp& op) {
+    io_uring_sqe* sqe = get_sqe();
+    if (!sqe) {
+        return false;
+    }
+    sqe->fd = op.fd;
+    sqe->user_data = (TAG_OP << TAG_SHIFT) | (op.token & TOKEN_MASK);
+    switch (op.type) {
+    case AsyncOpType::READ:
+        sqe->opcode = IORING_OP_READ;
+        sqe->addr = reinterpret_cast<uint64_t>(op.buf);
+        sqe->len = op.len;
+        sqe->off = -1;
+        break;
+    case AsyncOpType::WRITE:
+        sqe->opcode = IORING_OP_WRITE;
+        sqe->addr = reinterpret_cast<uint64_t>(op.buf);
+        sqe->len = op.len;
+        sqe->off = -1;
+        break;
+    case AsyncOpType::ACCEPT:
+        sqe->opcode = IORING_OP_ACCEPT;
+        sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+        break;
+    }
+    publish_sqe(sq_tail_);
+    return true;
+}
+
+void UringBackend::prepare() {
+    size_t count = rearm_.size();
+    for (size_t i = 0; i < count; i++) {
+        int fd = rearm_[i];
+        PollReg* reg = find_reg(fd);
+        if (reg && !reg->armed) {
+            reg->armed = queue_poll(fd, *reg);
+            if (!reg->armed) {
+                rearm_.push_back(fd);
+            }
+        }
+    }
+    rearm_.erase(rearm_.begin(), rearm_.begin() + count);
+}
+
+int UringBackend::wait(std::chrono::nanoseconds timeout) {
+    unsigned to_submit = __atomic_load_n(sq_tail_, __ATOMIC_ACQUIRE) -
+        __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+    unsigned ready = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE) - *cq_head_;
+    unsigned min_complete = (ready > 0 || timeout.count() == 0) ? 0 : 1;
+
+    int result = enter(to_submit, min_complete, IORING_ENTER_GETEVENTS,
+                       min_complete ? timeout : std::chrono::nanoseconds(-1));
+    if (result < 0 && errno != ETIME && errno != EBUSY) {
+        return -1;
+    }
+    return __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE) - *cq_head_;
+}
+
+void UringBackend::collect(std::vector<pollfd>& ready, std::vector<Completion>& done) {
+    ready.clear();
+    done.clear();
+    collect_count_++;
+
+    unsigned head = *cq_head_;
+    unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+
+    for (; head != tail; head++) {
+        const io_uring_cqe& cqe = cqes_[head & *cq_mask_];
+        uint64_t tag = cqe.user_data >> TAG_SHIFT;
+
+        if (tag == TAG_OP) {
+            done.push_back({cqe.user_data & TOKEN_MASK, cqe.res});
+        } else if (tag == TAG_POLL) {
+            int fd = static_cast<int>(cqe.user_data & 0xffffffff);
+            uint32_t seq = (cqe.user_data >> 32) & 0xffffff;
+            PollReg* reg = find_reg(fd);
+            if (!reg || (reg->seq & 0xffffff) != seq) {
+                continue;
+            }
+            if (!(cqe.flags & IORING_CQE_F_MORE)) {
+                reg->armed = false;
+                if (!(reg->mode & POLL_ONESHOT)) {
+                    rearm_.push_back(fd);
+                }
+            }
+            if (cqe.res == 0 || cqe.res == -ECANCELED) {
+                continue;
+            }
+            short revents = cqe.res > 0 ? static_cast<short>(cqe.res) : POLLNVAL;
+            if (reg->collected == collect_count_) {
+                ready[reg->ready_index].revents |= revents;
+                continue;
+            }
+            reg->collected = collect_count_;
+            reg->ready_index = ready.size();
+            ready.push_back({
+                .fd = fd,
+                .events = reg->events,
+                .revents = revents
+            });
+        }
+    }
+
+    __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+}
@@ -0,0 +1,159 @@
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <execinfo.h>
+#include "watchdog.h"
+//#define DEBUG
+
+#ifdef DEBUG
+#define dbg(a...) do { \
+    std::cerr << "[DEBUG] " << __FILE__ << ":" << __LINE__ << ":" << __FUNCTION__ <<" "; \
+    fprintf(stderr, a); \
+    std::cerr << std::endl; \
+} while(0)
+#else
+#define dbg(fmt, ...) do { } while(0)
+#endif
+
+static constexpr int MAX_FRAMES = 64;
+
+// One capture at a time process wide; the handler fills these in on the
+// loop thread.
+static std::mutex capture_mutex;
+static void* capture_frames[MAX_FRAMES];
+static std::atomic<int> capture_count{-1};
+
+static void backtrace_handler(int sig) {
+    (void)sig;
+    int count = backtrace(capture_frames, MAX_FRAMES);
+    capture_count.store(count, std::memory_order_release);
+}
+
+static bool install_backtrace_handler(int sig) {
+    // backtrace() loads libgcc on first use, which must not happen inside
+    // the handler.
+    void* warmup[1];
+    backtrace(warmup, 1);
+
+    struct sigaction sa{};
+    sa.sa_handler = backtrace_handler;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = SA_RESTART;
+    if (sigaction(sig, &sa, nullptr) < 0) {
+        std::cerr << "Failed to install backtrace handler: " << strerror(errno) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+LoopWatchdog::LoopWatchdog(const LoopCounters& counters, std::chrono::milliseconds threshold,
+                           StallCallback hook, int backtrace_signal)
+    : counters_(counters), threshold_(threshold), hook_(std::move(hook)),
+    backtrace_signal_(backtrace_signal) {
+    if (backtrace_signal_ > 0 && !install_backtrace_handler(backtrace_signal_)) {
+        backtrace_signal_ = 0;
+    }
+    thread_ = std::thread([this]() { watch(); });
+}
+
+LoopWatchdog::~LoopWatchdog() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stop_ = true;
+    }
+    cv_.notify_one();
+    thread_.join();
+}
+
+void LoopWatchdog::attach(pthread_t loop_thread) {
+    std::lock_guard<std::mutex> lock(mtx);
+    loop_thread_ = loop_thread;
+    attached_.store(true);
+}
+
+void LoopWatchdog::detach() {
+    std::lock_guard<std::mutex> lock(mtx);
+    attached_.store(false);
+}
+
+// Polls at a quarter of the threshold, so a stall is noticed at most 25%
+// late.
+void LoopWatchdog::watch() {
+    // Process signals are left to the threads that expect them, e.g. a
+    // loop taking them through a signalfd.
+    sigset_t all;
+    sigfillset(&all);
+    pthread_sigmask(SIG_BLOCK, &all, nullptr);
+
+    auto period = std::max<std::chrono::milliseconds>(threshold_ / 4, std::chrono::milliseconds(1));
+    std::unique_lock<std::mutex> lock(mtx);
+    while (!cv_.wait_for(lock, period, [this]() { return stop_; })) {
+        uint64_t since = counters_.busy_since_ns();
+        if (since == 0 || since == reported_since_) {
+            continue;
+        }
+        auto now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            LoopCounters::Clock::now().time_since_epoch());
+        auto stalled = now - std::chrono::nanoseconds(since);
+        if (stalled < threshold_) {
+            continue;
+        }
+
+        reported_since_ = since;
+        StallReport report{stalled, counters_.current_fd(), counters_.current_timer_id(), {}};
+        lock.unlock();
+        if (backtrace_signal_ > 0 && attached_.load()) {
+            report.backtrace = capture_backtrace();
+        }
+        dbg("loop stalled for %ld us", static_cast<long>(stalled.count() / 1000));
+        try {
+            hook_(report);
+        } catch (const std::exception& e) {
+            std::cerr << "Exception in stall hook: " << e.what() << std::endl;
+        } catch (...) {
+            std::cerr << "Unknown exception in stall hook" << std::endl;
+        }
+        lock.lock();
+    }
+}
+
+std::vector<std::string> LoopWatchdog::capture_backtrace() {
+    std::vector<std::string> frames;
+    std::lock_guard<std::mutex> capture(capture_mutex);
+    pthread_t target;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (!attached_.load()) {
+            return frames;
+        }
+        target = loop_thread_;
+    }
+
+    capture_count.store(-1, std::memory_order_relaxed);
+    int rc = pthread_kill(target, backtrace_signal_);
+    if (rc != 0) {
+        dbg("pthread_kill failed: %s", strerror(rc));
+        return frames;
+    }
+
+    int count = -1;
+    for (int i = 0; i < 100 && count < 0; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        count = capture_count.load(std::memory_order_acquire);
+    }
+    if (count <= 0) {
+        return frames;
+    }
+
+    char** symbols = backtrace_symbols(capture_frames, count);
+    if (!symbols) {
+        return frames;
+    }
+    for (int i = 0; i < count; i++) {
+        frames.emplace_back(symbols[i]);
+    }
+    free(symbols);
+    return frames;
+}
@@ -0,0 +1,60 @@
+#include "evloop.h"
+#include <atomic>
+#include <thread>
+#include "test_util.h"
+
+// The loop's destructor waits for blocking work that is still running, and
+// returns as soon as the last job finishes.
+static void destructor_waits() {
+    BlockingPool pool(2);
+    std::atomic<int> finished{0};
+    auto start = std::chrono::steady_clock::now();
+    {
+        LocalEvLoop ev(BackendType::EPOLL);
+        ev.set_blocking_pool(pool);
+        for (int i = 0; i < 4; i++) {
+            CHECK(ev.submit_blocking([&finished]() {
+                std::this_thread::sleep_for(std::chrono::milliseconds(30));
+                finished++;
+            }));
+        }
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    CHECK(finished.load() == 4);
+    CHECK(elapsed >= std::chrono::milliseconds(60));
+    CHECK(elapsed < std::chrono::milliseconds(500));
+}
+
+// Every job runs once with its completion on the loop, and the depth is
+// back to zero afterwards.
+static void completions(size_t jobs) {
+    BlockingPool pool(3);
+    LocalEvLoop ev(BackendType::EPOLL);
+    ev.set_blocking_pool(pool);
+    std::atomic<size_t> ran{0};
+    size_t done = 0;
+    ev.post([&]() {
+        for (size_t i = 0; i < jobs; i++) {
+            ev.submit_blocking([&ran]() { ran++; }, [&]() {
+                if (++done == jobs) {
+                    ev.stop();
+                }
+            });
+        }
+    });
+    ev.add_timer(5000, [&](int) { ev.stop(); }, false);
+    ev.run(-1);
+
+    BlockingPoolStats stats = pool.get_stats();
+    CHECK(ran.load() == jobs);
+    CHECK(done == jobs);
+    CHECK(stats.depth == 0);
+    CHECK(stats.submitted == jobs);
+    CHECK(stats.max_depth >= 1 && stats.max_depth <= jobs);
+}
+
+int main() {
+    destructor_waits();
+    completions(20000);
+    return test_result("blocking_pool_test");
+}
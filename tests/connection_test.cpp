@@ -0,0 +1,184 @@
+#include "coro.h"
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include <sys/socket.h>
+#include "test_util.h"
+
+static bool make_pair(int sv[2]) {
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, sv) < 0) {
+        perror("socketpair");
+        return false;
+    }
+    return true;
+}
+
+// A watermark callback that replaces the data callback must itself stay
+// installed and fire on the next crossing.
+static void watermark_keeps_callback(BackendType type) {
+    LocalEvLoop ev(type);
+    int sv[2];
+    if (!make_pair(sv)) {
+        test_failures()++;
+        return;
+    }
+    auto conn = std::make_shared<LocalConnection>(ev, sv[0]);
+    int highs = 0;
+    int lows = 0;
+    conn->set_watermarks(16 * 1024, 64 * 1024,
+        [&](LocalConnection& c, size_t) {
+            highs++;
+            c.set_data_callback([](LocalConnection&, ChainBuffer&) {});
+        },
+        [&](LocalConnection&, size_t) { lows++; });
+    CHECK(conn->start());
+
+    std::string chunk(4 << 20, 'x');
+    auto drain = [&]() {
+        char buf[65536];
+        while (read(sv[1], buf, sizeof(buf)) > 0) {
+        }
+    };
+    ev.add(sv[1], POLLIN, [&](int, short, short) { drain(); });
+    ev.post([&]() { conn->send(chunk); });
+    ev.add_timer(100, [&](int) { conn->send(chunk); }, false);
+    ev.add_timer(200, [&](int) { ev.stop(); }, false);
+    ev.run(-1);
+
+    CHECK(highs == 2);
+    CHECK(lows == 2);
+    ev.remove(sv[1]);
+    conn->close();
+    close(sv[1]);
+}
+
+// Awaiting a read leaves the user's callbacks alone: data after the
+// coroutine is done goes to the data callback and a later peer close is
+// still reported.
+static void read_keeps_callbacks(BackendType type) {
+    LocalEvLoop ev(type);
+    int sv[2];
+    if (!make_pair(sv)) {
+        test_failures()++;
+        return;
+    }
+    auto conn = std::make_shared<LocalConnection>(ev, sv[0]);
+    std::string awaited;
+    std::string received;
+    int closes = 0;
+    conn->set_data_callback([&](LocalConnection&, ChainBuffer& input) {
+        received += std::string(input.front());
+        input.consume(input.front().size());
+    });
+    conn->set_close_callback([&](LocalConnection&, int error) {
+        closes++;
+        CHECK(error == 0);
+        ev.stop();
+    });
+    CHECK(conn->start());
+
+    auto reader = [&]() -> Task<> {
+        char buf[16];
+        size_t n = co_await read(*conn, buf, sizeof(buf));
+        awaited.assign(buf, n);
+    };
+    ev.post([&]() {
+        spawn(reader());
+        CHECK(write(sv[1], "first", 5) == 5);
+    });
+    ev.add_timer(20, [&](int) { CHECK(write(sv[1], "second", 6) == 6); }, false);
+    ev.add_timer(40, [&](int) { close(sv[1]); }, false);
+    ev.add_timer(1000, [&](int) { ev.stop(); }, false);
+    ev.run(-1);
+
+    CHECK(awaited == "first");
+    CHECK(received == "second");
+    CHECK(closes == 1);
+}
+
+// A coroutine waiting in read() gets 0 when the peer closes, and the close
+// callback runs as well.
+static void close_wakes_reader(BackendType type) {
+    LocalEvLoop ev(type);
+    int sv[2];
+    if (!make_pair(sv)) {
+        test_failures()++;
+        return;
+    }
+    auto conn = std::make_shared<LocalConnection>(ev, sv[0]);
+    int closes = 0;
+    size_t result = 1;
+    bool done = false;
+    conn->set_close_callback([&](LocalConnection&, int) { closes++; });
+    CHECK(conn->start());
+
+    auto reader = [&]() -> Task<> {
+        char buf[16];
+        result = co_await read(*conn, buf, sizeof(buf));
+        done = true;
+    };
+    ev.post([&]() { spawn(reader()); });
+    ev.add_timer(10, [&](int) { close(sv[1]); }, false);
+    ev.add_timer(50, [&](int) { ev.stop(); }, false);
+    ev.run(-1);
+
+    CHECK(done);
+    CHECK(result == 0);
+    CHECK(closes == 1);
+}
+
+// On a seqpacket socket every write is one record, so the records the peer
+// receives count the writes. Sends from one data callback go out as one
+// write, and so do sends made outside a callback within one iteration.
+static void sends_batched(BackendType type) {
+    LocalEvLoop ev(type);
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, sv) < 0) {
+        perror("socketpair");
+        test_failures()++;
+        return;
+    }
+    auto conn = std::make_shared<LocalConnection>(ev, sv[0]);
+    conn->set_data_callback([](LocalConnection& c, ChainBuffer& input) {
+        input.clear();
+        c.send("a");
+        c.send("b");
+        c.send("c");
+    });
+    CHECK(conn->start());
+
+    std::vector<std::string> records;
+    ev.add(sv[1], POLLIN, [&](int fd, short, short) {
+        char buf[64];
+        ssize_t n;
+        while ((n = recv(fd, buf, sizeof(buf), 0)) > 0) {
+            records.emplace_back(buf, n);
+        }
+    });
+    ev.post([&]() { CHECK(write(sv[1], "x", 1) == 1); });
+    ev.add_timer(20, [&](int) {
+        conn->send("1");
+        conn->send("2");
+        char buf[8];
+        CHECK(recv(sv[1], buf, sizeof(buf), 0) < 0);
+        conn->send("3");
+    }, false);
+    ev.add_timer(40, [&](int) { ev.stop(); }, false);
+    ev.run(-1);
+
+    CHECK(records == std::vector<std::string>({"abc", "123"}));
+    CHECK(conn->pending() == 0);
+    ev.remove(sv[1]);
+    conn->close();
+    close(sv[1]);
+}
+
+int main() {
+    for (auto type : {BackendType::POLL, BackendType::EPOLL, BackendType::URING}) {
+        watermark_keeps_callback(type);
+        read_keeps_callbacks(type);
+        close_wakes_reader(type);
+        sends_batched(type);
+    }
+    return test_result("connection_test");
+}
@@ -0,0 +1,144 @@
+#include "evloop.h"
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+#include <sys/socket.h>
+#include "test_util.h"
+
+// Order within an iteration: fd events, then deferred callbacks, then
+// check hooks. A flush deferred by several events runs once, and work it
+// defers waits for the next iteration.
+static void order(BackendType type) {
+    LocalEvLoop ev(type);
+    std::string log;
+    int sv[3][2];
+    int flushes = 0;
+    bool flush_queued = false;
+    for (auto& pair : sv) {
+        if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, pair) < 0) {
+            perror("socketpair");
+            test_failures()++;
+            return;
+        }
+        ev.add(pair[0], POLLIN, [&](int fd, short, short) {
+            char buf[16];
+            while (read(fd, buf, sizeof(buf)) > 0) {
+            }
+            log += "r";
+            if (!flush_queued) {
+                flush_queued = true;
+                ev.defer([&]() {
+                    flush_queued = false;
+                    flushes++;
+                    log += "D";
+                    ev.defer([&]() { log += "N"; });
+                });
+            }
+        });
+    }
+    int prepares = 0;
+    int checks = 0;
+    ev.add_prepare([&]() { prepares++; });
+    ev.add_check([&]() {
+        checks++;
+        log += "C";
+    });
+    int self = -1;
+    self = ev.add_check([&]() {
+        log += "S";
+        CHECK(ev.remove_hook(self));
+    });
+    CHECK(ev.add_check(nullptr) == -1);
+    int thrower = ev.add_prepare([]() { throw std::runtime_error("expected exception from a hook"); });
+
+    ev.post([&]() {
+        for (auto& pair : sv) {
+            CHECK(write(pair[1], "x", 1) == 1);
+        }
+    });
+    ev.add_timer(50, [&](int) {
+        CHECK(ev.remove_hook(thrower));
+        CHECK(!ev.remove_hook(thrower));
+        ev.stop();
+    }, false);
+    ev.run(-1);
+
+    CHECK(log.substr(0, 2) == "CS");
+    CHECK(log.find("rrrDC") != std::string::npos);
+    CHECK(log.find("DCNC") != std::string::npos);
+    CHECK(log.find('S', 2) == std::string::npos);
+    CHECK(flushes == 1);
+    CHECK(prepares == checks);
+    for (auto& pair : sv) {
+        ev.remove(pair[0]);
+        close(pair[0]);
+        close(pair[1]);
+    }
+}
+
+// Idle hooks never run while every wait returns events, and run once the
+// waits start timing out.
+static void idle_under_load(BackendType type) {
+    LocalEvLoop ev(type);
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sv) < 0) {
+        perror("socketpair");
+        test_failures()++;
+        return;
+    }
+    // Left unread, so the fd is reported on every pass.
+    CHECK(write(sv[1], "x", 1) == 1);
+    int events = 0;
+    ev.add(sv[0], POLLIN, [&](int, short, short) { events++; });
+    int idles = 0;
+    int idles_while_busy = -1;
+    ev.add_idle([&]() { idles++; });
+    ev.add_timer(30, [&](int) {
+        idles_while_busy = idles;
+        ev.remove(sv[0]);
+    }, false);
+    ev.add_timer(80, [&](int) { ev.stop(); }, false);
+    ev.run(5);
+
+    CHECK(events > 100);
+    CHECK(idles_while_busy == 0);
+    CHECK(idles >= 3);
+    close(sv[0]);
+    close(sv[1]);
+}
+
+// Idle hooks do not run while posted work keeps the loop busy, and a hook
+// added by a hook runs from the next pass on.
+static void idle_with_posts(BackendType type) {
+    LocalEvLoop ev(type);
+    int idles = 0;
+    int posts = 0;
+    int added = 0;
+    std::function<void()> again = [&]() {
+        if (++posts < 1000) {
+            ev.post(again);
+        }
+    };
+    ev.post(again);
+    ev.add_idle([&]() {
+        if (++idles == 1) {
+            CHECK(posts == 1000);
+            ev.add_idle([&]() { added++; });
+        }
+    });
+    ev.add_timer(40, [&](int) { ev.stop(); }, false);
+    ev.run(5);
+
+    CHECK(posts == 1000);
+    CHECK(idles >= 2);
+    CHECK(added == idles - 1);
+}
+
+int main() {
+    for (auto type : {BackendType::POLL, BackendType::EPOLL, BackendType::URING}) {
+        order(type);
+        idle_under_load(type);
+        idle_with_posts(type);
+    }
+    return test_result("loop_hooks_test");
+}
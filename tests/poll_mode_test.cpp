@@ -0,0 +1,211 @@
+#include "poller.h"
+#include <cerrno>
+#include <unistd.h>
+#include <sys/socket.h>
+#include "test_util.h"
+
+static void passes(Poller& poller, int count) {
+    for (int i = 0; i < count; i++) {
+        poller.poll(10);
+    }
+}
+
+static bool make_pair(int sv[2]) {
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, sv) < 0) {
+        perror("socketpair");
+        test_failures()++;
+        return false;
+    }
+    return true;
+}
+
+static void send_bytes(int fd, size_t len) {
+    char buf[4096] = {};
+    while (len > 0) {
+        ssize_t n = write(fd, buf, std::min(len, sizeof(buf)));
+        CHECK(n > 0);
+        if (n <= 0) {
+            return;
+        }
+        len -= n;
+    }
+}
+
+// Reads until EAGAIN, which is what an edge-triggered callback must do.
+static size_t drain(int fd) {
+    char buf[100];
+    size_t total = 0;
+    for (;;) {
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if (n > 0) {
+            total += n;
+            continue;
+        }
+        CHECK(n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK));
+        return total;
+    }
+}
+
+// An edge fd drained to EAGAIN is not reported again until new data
+// arrives, and every byte is seen.
+static void edge_drained(BackendType type) {
+    Poller poller(type);
+    int sv[2];
+    if (!make_pair(sv)) {
+        return;
+    }
+    int reports = 0;
+    size_t received = 0;
+    CHECK(poller.add(sv[0], POLLIN, [&](int fd, short, short) {
+        reports++;
+        received += drain(fd);
+    }, POLL_EDGE));
+
+    send_bytes(sv[1], 1000);
+    passes(poller, 5);
+    CHECK(reports == 1);
+    CHECK(received == 1000);
+
+    send_bytes(sv[1], 333);
+    passes(poller, 5);
+    CHECK(reports == 2);
+    CHECK(received == 1333);
+
+    // Bursts of writes between passes: at most one report per pass.
+    size_t sent = 1333;
+    for (int burst = 0; burst < 20; burst++) {
+        for (int i = 0; i < 5; i++) {
+            send_bytes(sv[1], 257);
+            sent += 257;
+        }
+        passes(poller, 1);
+    }
+    passes(poller, 2);
+    CHECK(received == sent);
+    CHECK(reports == 22);
+
+    poller.remove(sv[0]);
+    close(sv[0]);
+    close(sv[1]);
+}
+
+// Readiness left behind by an edge callback: epoll and io_uring only
+// report the fd again on new data, while poll, which cannot see
+// transitions, keeps reporting it like a level-triggered fd.
+static void edge_not_drained(BackendType type) {
+    Poller poller(type);
+    int sv[2];
+    if (!make_pair(sv)) {
+        return;
+    }
+    int reports = 0;
+    CHECK(poller.add(sv[0], POLLIN, [&](int, short, short) { reports++; }, POLL_EDGE));
+
+    send_bytes(sv[1], 1);
+    passes(poller, 5);
+    if (type == BackendType::POLL) {
+        CHECK(reports == 5);
+    } else {
+        CHECK(reports == 1);
+    }
+
+    send_bytes(sv[1], 1);
+    passes(poller, 5);
+    if (type == BackendType::POLL) {
+        CHECK(reports == 10);
+    } else {
+        CHECK(reports == 2);
+    }
+
+    poller.remove(sv[0]);
+    close(sv[0]);
+    close(sv[1]);
+}
+
+// A oneshot fd is reported once, stays quiet while still readable, and is
+// reported again after rearm() and after update_events().
+static void oneshot(BackendType type, unsigned mode) {
+    Poller poller(type);
+    int sv[2];
+    if (!make_pair(sv)) {
+        return;
+    }
+    int reports = 0;
+    CHECK(poller.add(sv[0], POLLIN, [&](int, short, short) { reports++; }, mode));
+
+    send_bytes(sv[1], 1);
+    passes(poller, 5);
+    CHECK(reports == 1);
+
+    CHECK(poller.rearm(sv[0]));
+    passes(poller, 5);
+    CHECK(reports == 2);
+
+    CHECK(poller.update_events(sv[0], POLLIN));
+    passes(poller, 5);
+    CHECK(reports == 3);
+
+    // Re-armed with nothing to read: quiet until data arrives.
+    drain(sv[0]);
+    CHECK(poller.rearm(sv[0]));
+    passes(poller, 3);
+    CHECK(reports == 3);
+    send_bytes(sv[1], 1);
+    passes(poller, 3);
+    CHECK(reports == 4);
+
+    // Only oneshot fds can be re-armed.
+    int other[2];
+    if (make_pair(other)) {
+        CHECK(poller.add(other[0], POLLIN, [](int, short, short) {}));
+        CHECK(!poller.rearm(other[0]));
+        poller.remove(other[0]);
+        close(other[0]);
+        close(other[1]);
+    }
+    CHECK(!poller.rearm(sv[1]));
+
+    poller.remove(sv[0]);
+    close(sv[0]);
+    close(sv[1]);
+}
+
+// A oneshot callback that drains and re-arms itself sees every write.
+static void oneshot_rearm_in_callback(BackendType type) {
+    Poller poller(type);
+    int sv[2];
+    if (!make_pair(sv)) {
+        return;
+    }
+    int reports = 0;
+    CHECK(poller.add(sv[0], POLLIN, [&](int fd, short, short) {
+        reports++;
+        drain(fd);
+        poller.rearm(fd);
+    }, POLL_EDGE | POLL_ONESHOT));
+    for (int i = 0; i < 10; i++) {
+        send_bytes(sv[1], 1);
+        passes(poller, 1);
+    }
+    passes(poller, 3);
+    CHECK(reports == 10);
+
+    poller.remove(sv[0]);
+    close(sv[0]);
+    close(sv[1]);
+}
+
+int main() {
+    for (auto type : {BackendType::POLL, BackendType::EPOLL, BackendType::URING}) {
+        int before = test_failures();
+        edge_drained(type);
+        edge_not_drained(type);
+        oneshot(type, POLL_ONESHOT);
+        oneshot(type, POLL_EDGE | POLL_ONESHOT);
+        oneshot_rearm_in_callback(type);
+        if (test_failures() != before) {
+            fprintf(stderr, "failures on %s\n", backend_name(type));
+        }
+    }
+    return test_result("poll_mode_test");
+}
@@ -0,0 +1,68 @@
+#include "evloop.h"
+#include <thread>
+#include <pthread.h>
+#include "test_util.h"
+
+static bool is_blocked(int signo) {
+    sigset_t mask;
+    pthread_sigmask(SIG_BLOCK, nullptr, &mask);
+    return sigismember(&mask, signo);
+}
+
+static void block(int signo, int how) {
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, signo);
+    pthread_sigmask(how, &mask, nullptr);
+}
+
+// remove_signal() unblocks only what add_signal() blocked.
+static void remove_keeps_caller_mask(BackendType type) {
+    LocalEvLoop ev(type);
+    block(SIGUSR2, SIG_BLOCK);
+    CHECK(ev.add_signal(SIGUSR1, [](int, uint32_t) {}));
+    CHECK(ev.add_signal(SIGUSR2, [](int, uint32_t) {}));
+    CHECK(is_blocked(SIGUSR1));
+    CHECK(ev.remove_signal(SIGUSR1));
+    CHECK(ev.remove_signal(SIGUSR2));
+    CHECK(!ev.remove_signal(SIGUSR2));
+    CHECK(!is_blocked(SIGUSR1));
+    CHECK(is_blocked(SIGUSR2));
+    block(SIGUSR2, SIG_UNBLOCK);
+}
+
+// A loop thread has the loop's signals blocked while run() lasts, gets them
+// through the signalfd, and has its own mask back once run() returns.
+static void run_restores_mask(BackendType type) {
+    EvLoop ev(type);
+    CHECK(ev.add_signal(SIGUSR1, [&](int signo, uint32_t count) {
+        CHECK(signo == SIGUSR1);
+        CHECK(count == 1);
+        ev.stop();
+    }));
+    block(SIGUSR1, SIG_UNBLOCK);
+
+    bool blocked_in_run = false;
+    bool blocked_after_run = true;
+    std::thread loop([&]() {
+        ev.post([&]() {
+            blocked_in_run = is_blocked(SIGUSR1);
+            pthread_kill(pthread_self(), SIGUSR1);
+        });
+        ev.run(-1);
+        blocked_after_run = is_blocked(SIGUSR1);
+    });
+    loop.join();
+
+    CHECK(blocked_in_run);
+    CHECK(!blocked_after_run);
+    CHECK(ev.remove_signal(SIGUSR1));
+}
+
+int main() {
+    for (auto type : {BackendType::POLL, BackendType::EPOLL, BackendType::URING}) {
+        remove_keeps_caller_mask(type);
+        run_restores_mask(type);
+    }
+    return test_result("signal_test");
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdio>
+#include "backend.h"
+
+// Minimal checks for the tests. A failed CHECK reports its location and
+// marks the run failed without stopping it, so one run lists every failure.
+
+inline int& test_failures() {
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+        test_failures()++; \
+    } \
+} while(0)
+
+inline const char* backend_name(BackendType type) {
+    switch (type) {
+    case BackendType::POLL:
+        return "poll";
+    case BackendType::EPOLL:
+        return "epoll";
+    default:
+        return "uring";
+    }
+}
+
+// Returns the exit status for main().
+inline int test_result(const char* name) {
+    if (test_failures()) {
+        fprintf(stderr, "%s: %d failed\n", name, test_failures());
+        return 1;
+    }
+    printf("%s: ok\n", name);
+    return 0;
+}
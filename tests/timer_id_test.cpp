@@ -0,0 +1,53 @@
+#include "evloop.h"
+#include "test_util.h"
+
+// A timer id must stop working once its timer is gone, even after the slot
+// has been reused by a new timer.
+static void stale_ids() {
+    LocalEvLoop ev(BackendType::EPOLL);
+    int fired = 0;
+    int first = ev.add_timer(1, [&](int) { fired++; }, false);
+    CHECK(first > 0);
+    ev.add_timer(20, [&](int) { ev.stop(); }, false);
+    ev.run(-1);
+    CHECK(fired == 1);
+
+    // The one-shot timer has fired; a new one takes over its slot.
+    int second = ev.add_timer(10, [&](int) { fired++; }, false);
+    CHECK(second > 0);
+    CHECK(second != first);
+    CHECK(!ev.remove_timer(first));
+    CHECK(!ev.update_timer_interval(first, 1000));
+    ev.add_timer(40, [&](int) { ev.stop(); }, false);
+    ev.run(-1);
+    CHECK(fired == 2);
+
+    // Removed timers too.
+    int third = ev.add_timer(1000, [](int) {}, false);
+    CHECK(ev.remove_timer(third));
+    int fourth = ev.add_timer(1000, [](int) {}, false);
+    CHECK(fourth != third);
+    CHECK(!ev.remove_timer(third));
+    CHECK(ev.remove_timer(fourth));
+}
+
+// Ids stay positive and distinct from the previous user of the slot over
+// many reuses, including generation wrap-around.
+static void reuse() {
+    LocalEvLoop ev(BackendType::EPOLL);
+    int previous = -1;
+    for (int i = 0; i < 5000; i++) {
+        int id = ev.add_timer(1000, [](int) {}, false);
+        CHECK(id > 0);
+        CHECK(id != previous);
+        CHECK(ev.remove_timer(id));
+        CHECK(!ev.remove_timer(id));
+        previous = id;
+    }
+}
+
+int main() {
+    stale_ids();
+    reuse();
+    return test_result("timer_id_test");
+}
@@ -0,0 +1,48 @@
+#include "evloop.h"
+#include <algorithm>
+#include <random>
+#include "test_util.h"
+
+using Clock = std::chrono::steady_clock;
+
+// One-shot WHEEL timers spread over several level-1 slots must fire close
+// to their deadline. The loop used to sleep past a rotation boundary whose
+// upper slot had not been cascaded yet, firing timers up to 256 ticks late.
+// The bound leaves room for scheduling noise on a loaded machine.
+static void fire_times(BackendType type, size_t count) {
+    LocalEvLoop ev(type);
+    CHECK(ev.configure_wheel(1, 3));
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> delay(1, 3000);
+    std::vector<Clock::duration> lateness;
+    lateness.reserve(count);
+    auto start = Clock::now();
+    for (size_t i = 0; i < count; i++) {
+        auto deadline = start + std::chrono::milliseconds(delay(rng));
+        ev.add_timer(deadline - start, [&, deadline](int) {
+            lateness.push_back(Clock::now() - deadline);
+            if (lateness.size() == count) {
+                ev.stop();
+            }
+        }, false, TimerMode::WHEEL);
+    }
+    ev.add_timer(5000, [&](int) { ev.stop(); }, false);
+    ev.run(-1);
+
+    CHECK(lateness.size() == count);
+    auto latest = std::max_element(lateness.begin(), lateness.end());
+    auto earliest = std::min_element(lateness.begin(), lateness.end());
+    CHECK(latest != lateness.end() && *latest < std::chrono::milliseconds(50));
+    CHECK(earliest != lateness.end() && *earliest >= Clock::duration::zero());
+    if (latest != lateness.end()) {
+        printf("%s: %zu timers, max late %.3f ms\n", backend_name(type), lateness.size(),
+               std::chrono::duration<double, std::milli>(*latest).count());
+    }
+}
+
+int main() {
+    for (auto type : {BackendType::POLL, BackendType::EPOLL, BackendType::URING}) {
+        fire_times(type, 2000);
+    }
+    return test_result("timer_wheel_test");
+}